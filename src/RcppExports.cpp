@@ -10,6 +10,37 @@ Rcpp::Rostream<true>&  Rcpp::Rcout = Rcpp::Rcpp_cout_get();
 Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
 #endif
 
+// check_fields_rcpp
+void check_fields_rcpp(const std::vector<std::string>& lhs, const std::vector<std::string>& rhs, const std::vector<std::string>& modifier, const std::vector<std::string>& lbound, const std::vector<std::string>& ubound);
+RcppExport SEXP _mxsem_check_fields_rcpp(SEXP lhsSEXP, SEXP rhsSEXP, SEXP modifierSEXP, SEXP lboundSEXP, SEXP uboundSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type lhs(lhsSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type rhs(rhsSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type modifier(modifierSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type lbound(lboundSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type ubound(uboundSEXP);
+    check_fields_rcpp(lhs, rhs, modifier, lbound, ubound);
+    return R_NilValue;
+END_RCPP
+}
+// check_syntax_rcpp
+Rcpp::DataFrame check_syntax_rcpp(const std::vector<std::string>& syntaxes, bool add_intercept, bool add_variance, bool add_exogenous_latent_covariances, bool add_exogenous_manifest_covariances, bool scale_latent_variance, bool scale_loading);
+RcppExport SEXP _mxsem_check_syntax_rcpp(SEXP syntaxesSEXP, SEXP add_interceptSEXP, SEXP add_varianceSEXP, SEXP add_exogenous_latent_covariancesSEXP, SEXP add_exogenous_manifest_covariancesSEXP, SEXP scale_latent_varianceSEXP, SEXP scale_loadingSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type syntaxes(syntaxesSEXP);
+    Rcpp::traits::input_parameter< bool >::type add_intercept(add_interceptSEXP);
+    Rcpp::traits::input_parameter< bool >::type add_variance(add_varianceSEXP);
+    Rcpp::traits::input_parameter< bool >::type add_exogenous_latent_covariances(add_exogenous_latent_covariancesSEXP);
+    Rcpp::traits::input_parameter< bool >::type add_exogenous_manifest_covariances(add_exogenous_manifest_covariancesSEXP);
+    Rcpp::traits::input_parameter< bool >::type scale_latent_variance(scale_latent_varianceSEXP);
+    Rcpp::traits::input_parameter< bool >::type scale_loading(scale_loadingSEXP);
+    rcpp_result_gen = Rcpp::wrap(check_syntax_rcpp(syntaxes, add_intercept, add_variance, add_exogenous_latent_covariances, add_exogenous_manifest_covariances, scale_latent_variance, scale_loading));
+    return rcpp_result_gen;
+END_RCPP
+}
 // clean_syntax
 std::vector<std::string> clean_syntax(const std::string& syntax);
 RcppExport SEXP _mxsem_clean_syntax(SEXP syntaxSEXP) {
@@ -21,6 +52,44 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// read_data_file_rcpp
+Rcpp::List read_data_file_rcpp(const std::string& file, const std::vector<std::string>& columns, bool moments);
+RcppExport SEXP _mxsem_read_data_file_rcpp(SEXP fileSEXP, SEXP columnsSEXP, SEXP momentsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type file(fileSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type columns(columnsSEXP);
+    Rcpp::traits::input_parameter< bool >::type moments(momentsSEXP);
+    rcpp_result_gen = Rcpp::wrap(read_data_file_rcpp(file, columns, moments));
+    return rcpp_result_gen;
+END_RCPP
+}
+// write_data_file_rcpp
+void write_data_file_rcpp(Rcpp::List data, const std::string& file);
+RcppExport SEXP _mxsem_write_data_file_rcpp(SEXP dataSEXP, SEXP fileSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::List >::type data(dataSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type file(fileSEXP);
+    write_data_file_rcpp(data, file);
+    return R_NilValue;
+END_RCPP
+}
+// factor_scores_rcpp
+Rcpp::List factor_scores_rcpp(Rcpp::List model, Rcpp::List data, std::string type, int n_threads);
+RcppExport SEXP _mxsem_factor_scores_rcpp(SEXP modelSEXP, SEXP dataSEXP, SEXP typeSEXP, SEXP n_threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::List >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< Rcpp::List >::type data(dataSEXP);
+    Rcpp::traits::input_parameter< std::string >::type type(typeSEXP);
+    Rcpp::traits::input_parameter< int >::type n_threads(n_threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(factor_scores_rcpp(model, data, type, n_threads));
+    return rcpp_result_gen;
+END_RCPP
+}
 // find_model_name
 Rcpp::List find_model_name(const std::string& syntax);
 RcppExport SEXP _mxsem_find_model_name(SEXP syntaxSEXP) {
@@ -32,9 +101,214 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// find_model_blocks_rcpp
+Rcpp::DataFrame find_model_blocks_rcpp(const std::string& syntax);
+RcppExport SEXP _mxsem_find_model_blocks_rcpp(SEXP syntaxSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type syntax(syntaxSEXP);
+    rcpp_result_gen = Rcpp::wrap(find_model_blocks_rcpp(syntax));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fixed_x_rcpp
+Rcpp::List fixed_x_rcpp(const std::vector<std::string>& lhs, const std::vector<std::string>& op, const std::vector<std::string>& rhs, const std::vector<std::string>& modifier, const std::vector<std::string>& manifests, SEXP data, bool unbiased);
+RcppExport SEXP _mxsem_fixed_x_rcpp(SEXP lhsSEXP, SEXP opSEXP, SEXP rhsSEXP, SEXP modifierSEXP, SEXP manifestsSEXP, SEXP dataSEXP, SEXP unbiasedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type lhs(lhsSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type op(opSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type rhs(rhsSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type modifier(modifierSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type manifests(manifestsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type data(dataSEXP);
+    Rcpp::traits::input_parameter< bool >::type unbiased(unbiasedSEXP);
+    rcpp_result_gen = Rcpp::wrap(fixed_x_rcpp(lhs, op, rhs, modifier, manifests, data, unbiased));
+    return rcpp_result_gen;
+END_RCPP
+}
+// parameter_table_groups_rcpp
+Rcpp::List parameter_table_groups_rcpp(const std::string& syntax, int n_groups, bool add_intercept, bool add_variance, bool add_exogenous_latent_covariances, bool add_exogenous_manifest_covariances, bool scale_latent_variance, bool scale_loading);
+RcppExport SEXP _mxsem_parameter_table_groups_rcpp(SEXP syntaxSEXP, SEXP n_groupsSEXP, SEXP add_interceptSEXP, SEXP add_varianceSEXP, SEXP add_exogenous_latent_covariancesSEXP, SEXP add_exogenous_manifest_covariancesSEXP, SEXP scale_latent_varianceSEXP, SEXP scale_loadingSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type syntax(syntaxSEXP);
+    Rcpp::traits::input_parameter< int >::type n_groups(n_groupsSEXP);
+    Rcpp::traits::input_parameter< bool >::type add_intercept(add_interceptSEXP);
+    Rcpp::traits::input_parameter< bool >::type add_variance(add_varianceSEXP);
+    Rcpp::traits::input_parameter< bool >::type add_exogenous_latent_covariances(add_exogenous_latent_covariancesSEXP);
+    Rcpp::traits::input_parameter< bool >::type add_exogenous_manifest_covariances(add_exogenous_manifest_covariancesSEXP);
+    Rcpp::traits::input_parameter< bool >::type scale_latent_variance(scale_latent_varianceSEXP);
+    Rcpp::traits::input_parameter< bool >::type scale_loading(scale_loadingSEXP);
+    rcpp_result_gen = Rcpp::wrap(parameter_table_groups_rcpp(syntax, n_groups, add_intercept, add_variance, add_exogenous_latent_covariances, add_exogenous_manifest_covariances, scale_latent_variance, scale_loading));
+    return rcpp_result_gen;
+END_RCPP
+}
 // parameter_table_rcpp
-Rcpp::List parameter_table_rcpp(const std::string& syntax, bool add_intercept, bool add_variance, bool add_exogenous_latent_covariances, bool add_exogenous_manifest_covariances, bool scale_latent_variance, bool scale_loading);
-RcppExport SEXP _mxsem_parameter_table_rcpp(SEXP syntaxSEXP, SEXP add_interceptSEXP, SEXP add_varianceSEXP, SEXP add_exogenous_latent_covariancesSEXP, SEXP add_exogenous_manifest_covariancesSEXP, SEXP scale_latent_varianceSEXP, SEXP scale_loadingSEXP) {
+SEXP parameter_table_rcpp(const std::string& syntax, bool add_intercept, bool add_variance, bool add_exogenous_latent_covariances, bool add_exogenous_manifest_covariances, bool scale_latent_variance, bool scale_loading, bool return_handle, int n_threads);
+RcppExport SEXP _mxsem_parameter_table_rcpp(SEXP syntaxSEXP, SEXP add_interceptSEXP, SEXP add_varianceSEXP, SEXP add_exogenous_latent_covariancesSEXP, SEXP add_exogenous_manifest_covariancesSEXP, SEXP scale_latent_varianceSEXP, SEXP scale_loadingSEXP, SEXP return_handleSEXP, SEXP n_threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type syntax(syntaxSEXP);
+    Rcpp::traits::input_parameter< bool >::type add_intercept(add_interceptSEXP);
+    Rcpp::traits::input_parameter< bool >::type add_variance(add_varianceSEXP);
+    Rcpp::traits::input_parameter< bool >::type add_exogenous_latent_covariances(add_exogenous_latent_covariancesSEXP);
+    Rcpp::traits::input_parameter< bool >::type add_exogenous_manifest_covariances(add_exogenous_manifest_covariancesSEXP);
+    Rcpp::traits::input_parameter< bool >::type scale_latent_variance(scale_latent_varianceSEXP);
+    Rcpp::traits::input_parameter< bool >::type scale_loading(scale_loadingSEXP);
+    Rcpp::traits::input_parameter< bool >::type return_handle(return_handleSEXP);
+    Rcpp::traits::input_parameter< int >::type n_threads(n_threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(parameter_table_rcpp(syntax, add_intercept, add_variance, add_exogenous_latent_covariances, add_exogenous_manifest_covariances, scale_latent_variance, scale_loading, return_handle, n_threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// missingness_patterns_rcpp
+Rcpp::List missingness_patterns_rcpp(Rcpp::List data, const std::vector<std::string>& manifests, const std::vector<std::string>& definition_variables, bool order_rows);
+RcppExport SEXP _mxsem_missingness_patterns_rcpp(SEXP dataSEXP, SEXP manifestsSEXP, SEXP definition_variablesSEXP, SEXP order_rowsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::List >::type data(dataSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type manifests(manifestsSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type definition_variables(definition_variablesSEXP);
+    Rcpp::traits::input_parameter< bool >::type order_rows(order_rowsSEXP);
+    rcpp_result_gen = Rcpp::wrap(missingness_patterns_rcpp(data, manifests, definition_variables, order_rows));
+    return rcpp_result_gen;
+END_RCPP
+}
+// save_model_handle
+void save_model_handle(SEXP handle, const std::string& file, const std::string& model_name);
+RcppExport SEXP _mxsem_save_model_handle(SEXP handleSEXP, SEXP fileSEXP, SEXP model_nameSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type handle(handleSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type file(fileSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type model_name(model_nameSEXP);
+    save_model_handle(handle, file, model_name);
+    return R_NilValue;
+END_RCPP
+}
+// load_model_file
+Rcpp::List load_model_file(const std::string& file, bool return_handle);
+RcppExport SEXP _mxsem_load_model_file(SEXP fileSEXP, SEXP return_handleSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type file(fileSEXP);
+    Rcpp::traits::input_parameter< bool >::type return_handle(return_handleSEXP);
+    rcpp_result_gen = Rcpp::wrap(load_model_file(file, return_handle));
+    return rcpp_result_gen;
+END_RCPP
+}
+// handle_parameter_table
+Rcpp::List handle_parameter_table(SEXP handle, Rcpp::Nullable<Rcpp::CharacterVector> columns, Rcpp::Nullable<Rcpp::IntegerVector> rows);
+RcppExport SEXP _mxsem_handle_parameter_table(SEXP handleSEXP, SEXP columnsSEXP, SEXP rowsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type handle(handleSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::CharacterVector> >::type columns(columnsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::IntegerVector> >::type rows(rowsSEXP);
+    rcpp_result_gen = Rcpp::wrap(handle_parameter_table(handle, columns, rows));
+    return rcpp_result_gen;
+END_RCPP
+}
+// handle_to_list
+Rcpp::List handle_to_list(SEXP handle);
+RcppExport SEXP _mxsem_handle_to_list(SEXP handleSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type handle(handleSEXP);
+    rcpp_result_gen = Rcpp::wrap(handle_to_list(handle));
+    return rcpp_result_gen;
+END_RCPP
+}
+// register_module_rcpp
+void register_module_rcpp(const std::string& name, const std::string& syntax);
+RcppExport SEXP _mxsem_register_module_rcpp(SEXP nameSEXP, SEXP syntaxSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type name(nameSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type syntax(syntaxSEXP);
+    register_module_rcpp(name, syntax);
+    return R_NilValue;
+END_RCPP
+}
+// registered_modules_rcpp
+std::vector<std::string> registered_modules_rcpp();
+RcppExport SEXP _mxsem_registered_modules_rcpp() {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    rcpp_result_gen = Rcpp::wrap(registered_modules_rcpp());
+    return rcpp_result_gen;
+END_RCPP
+}
+// clear_modules_rcpp
+void clear_modules_rcpp();
+RcppExport SEXP _mxsem_clear_modules_rcpp() {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    clear_modules_rcpp();
+    return R_NilValue;
+END_RCPP
+}
+// observed_moments_rcpp
+SEXP observed_moments_rcpp(Rcpp::List data, const std::vector<std::string>& columns);
+RcppExport SEXP _mxsem_observed_moments_rcpp(SEXP dataSEXP, SEXP columnsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::List >::type data(dataSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type columns(columnsSEXP);
+    rcpp_result_gen = Rcpp::wrap(observed_moments_rcpp(data, columns));
+    return rcpp_result_gen;
+END_RCPP
+}
+// clear_moment_cache_rcpp
+void clear_moment_cache_rcpp();
+RcppExport SEXP _mxsem_clear_moment_cache_rcpp() {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    clear_moment_cache_rcpp();
+    return R_NilValue;
+END_RCPP
+}
+// optimize_algebras_rcpp
+Rcpp::List optimize_algebras_rcpp(const std::vector<std::string>& lhs, const std::vector<std::string>& rhs, const std::vector<std::string>& referenced, const std::vector<std::string>& user_defined);
+RcppExport SEXP _mxsem_optimize_algebras_rcpp(SEXP lhsSEXP, SEXP rhsSEXP, SEXP referencedSEXP, SEXP user_definedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type lhs(lhsSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type rhs(rhsSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type referenced(referencedSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type user_defined(user_definedSEXP);
+    rcpp_result_gen = Rcpp::wrap(optimize_algebras_rcpp(lhs, rhs, referenced, user_defined));
+    return rcpp_result_gen;
+END_RCPP
+}
+// pack_algebras_rcpp
+Rcpp::List pack_algebras_rcpp(const std::vector<std::string>& lhs, const std::vector<std::string>& rhs, const std::vector<std::string>& user_defined);
+RcppExport SEXP _mxsem_pack_algebras_rcpp(SEXP lhsSEXP, SEXP rhsSEXP, SEXP user_definedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type lhs(lhsSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type rhs(rhsSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type user_defined(user_definedSEXP);
+    rcpp_result_gen = Rcpp::wrap(pack_algebras_rcpp(lhs, rhs, user_defined));
+    return rcpp_result_gen;
+END_RCPP
+}
+// parameter_tables_rcpp
+Rcpp::List parameter_tables_rcpp(const std::string& syntax, bool add_intercept, bool add_variance, bool add_exogenous_latent_covariances, bool add_exogenous_manifest_covariances, bool scale_latent_variance, bool scale_loading, int n_threads);
+RcppExport SEXP _mxsem_parameter_tables_rcpp(SEXP syntaxSEXP, SEXP add_interceptSEXP, SEXP add_varianceSEXP, SEXP add_exogenous_latent_covariancesSEXP, SEXP add_exogenous_manifest_covariancesSEXP, SEXP scale_latent_varianceSEXP, SEXP scale_loadingSEXP, SEXP n_threadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -45,7 +319,58 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< bool >::type add_exogenous_manifest_covariances(add_exogenous_manifest_covariancesSEXP);
     Rcpp::traits::input_parameter< bool >::type scale_latent_variance(scale_latent_varianceSEXP);
     Rcpp::traits::input_parameter< bool >::type scale_loading(scale_loadingSEXP);
-    rcpp_result_gen = Rcpp::wrap(parameter_table_rcpp(syntax, add_intercept, add_variance, add_exogenous_latent_covariances, add_exogenous_manifest_covariances, scale_latent_variance, scale_loading));
+    Rcpp::traits::input_parameter< int >::type n_threads(n_threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(parameter_tables_rcpp(syntax, add_intercept, add_variance, add_exogenous_latent_covariances, add_exogenous_manifest_covariances, scale_latent_variance, scale_loading, n_threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// parameter_table_from_partable_rcpp
+Rcpp::List parameter_table_from_partable_rcpp(Rcpp::CharacterVector lhs, Rcpp::CharacterVector op, Rcpp::CharacterVector rhs, Rcpp::CharacterVector modifier, Rcpp::CharacterVector lbound, Rcpp::CharacterVector ubound, bool add_intercept, bool add_variance, bool add_exogenous_latent_covariances, bool add_exogenous_manifest_covariances, bool scale_latent_variance, bool scale_loading);
+RcppExport SEXP _mxsem_parameter_table_from_partable_rcpp(SEXP lhsSEXP, SEXP opSEXP, SEXP rhsSEXP, SEXP modifierSEXP, SEXP lboundSEXP, SEXP uboundSEXP, SEXP add_interceptSEXP, SEXP add_varianceSEXP, SEXP add_exogenous_latent_covariancesSEXP, SEXP add_exogenous_manifest_covariancesSEXP, SEXP scale_latent_varianceSEXP, SEXP scale_loadingSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::CharacterVector >::type lhs(lhsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::CharacterVector >::type op(opSEXP);
+    Rcpp::traits::input_parameter< Rcpp::CharacterVector >::type rhs(rhsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::CharacterVector >::type modifier(modifierSEXP);
+    Rcpp::traits::input_parameter< Rcpp::CharacterVector >::type lbound(lboundSEXP);
+    Rcpp::traits::input_parameter< Rcpp::CharacterVector >::type ubound(uboundSEXP);
+    Rcpp::traits::input_parameter< bool >::type add_intercept(add_interceptSEXP);
+    Rcpp::traits::input_parameter< bool >::type add_variance(add_varianceSEXP);
+    Rcpp::traits::input_parameter< bool >::type add_exogenous_latent_covariances(add_exogenous_latent_covariancesSEXP);
+    Rcpp::traits::input_parameter< bool >::type add_exogenous_manifest_covariances(add_exogenous_manifest_covariancesSEXP);
+    Rcpp::traits::input_parameter< bool >::type scale_latent_variance(scale_latent_varianceSEXP);
+    Rcpp::traits::input_parameter< bool >::type scale_loading(scale_loadingSEXP);
+    rcpp_result_gen = Rcpp::wrap(parameter_table_from_partable_rcpp(lhs, op, rhs, modifier, lbound, ubound, add_intercept, add_variance, add_exogenous_latent_covariances, add_exogenous_manifest_covariances, scale_latent_variance, scale_loading));
+    return rcpp_result_gen;
+END_RCPP
+}
+// person_fit_rcpp
+Rcpp::List person_fit_rcpp(Rcpp::List model, Rcpp::List data, bool implied_moments, int n_threads);
+RcppExport SEXP _mxsem_person_fit_rcpp(SEXP modelSEXP, SEXP dataSEXP, SEXP implied_momentsSEXP, SEXP n_threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::List >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< Rcpp::List >::type data(dataSEXP);
+    Rcpp::traits::input_parameter< bool >::type implied_moments(implied_momentsSEXP);
+    Rcpp::traits::input_parameter< int >::type n_threads(n_threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(person_fit_rcpp(model, data, implied_moments, n_threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ram_structure_rcpp
+Rcpp::List ram_structure_rcpp(const std::vector<std::string>& lhs, const std::vector<std::string>& op, const std::vector<std::string>& rhs, const std::vector<std::string>& variables);
+RcppExport SEXP _mxsem_ram_structure_rcpp(SEXP lhsSEXP, SEXP opSEXP, SEXP rhsSEXP, SEXP variablesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type lhs(lhsSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type op(opSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type rhs(rhsSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type variables(variablesSEXP);
+    rcpp_result_gen = Rcpp::wrap(ram_structure_rcpp(lhs, op, rhs, variables));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -63,9 +388,33 @@ END_RCPP
 }
 
 static const R_CallMethodDef CallEntries[] = {
+    {"_mxsem_check_fields_rcpp", (DL_FUNC) &_mxsem_check_fields_rcpp, 5},
+    {"_mxsem_check_syntax_rcpp", (DL_FUNC) &_mxsem_check_syntax_rcpp, 7},
     {"_mxsem_clean_syntax", (DL_FUNC) &_mxsem_clean_syntax, 1},
+    {"_mxsem_read_data_file_rcpp", (DL_FUNC) &_mxsem_read_data_file_rcpp, 3},
+    {"_mxsem_write_data_file_rcpp", (DL_FUNC) &_mxsem_write_data_file_rcpp, 2},
+    {"_mxsem_factor_scores_rcpp", (DL_FUNC) &_mxsem_factor_scores_rcpp, 4},
     {"_mxsem_find_model_name", (DL_FUNC) &_mxsem_find_model_name, 1},
-    {"_mxsem_parameter_table_rcpp", (DL_FUNC) &_mxsem_parameter_table_rcpp, 7},
+    {"_mxsem_find_model_blocks_rcpp", (DL_FUNC) &_mxsem_find_model_blocks_rcpp, 1},
+    {"_mxsem_fixed_x_rcpp", (DL_FUNC) &_mxsem_fixed_x_rcpp, 7},
+    {"_mxsem_parameter_table_groups_rcpp", (DL_FUNC) &_mxsem_parameter_table_groups_rcpp, 8},
+    {"_mxsem_parameter_table_rcpp", (DL_FUNC) &_mxsem_parameter_table_rcpp, 9},
+    {"_mxsem_missingness_patterns_rcpp", (DL_FUNC) &_mxsem_missingness_patterns_rcpp, 4},
+    {"_mxsem_save_model_handle", (DL_FUNC) &_mxsem_save_model_handle, 3},
+    {"_mxsem_load_model_file", (DL_FUNC) &_mxsem_load_model_file, 2},
+    {"_mxsem_handle_parameter_table", (DL_FUNC) &_mxsem_handle_parameter_table, 3},
+    {"_mxsem_handle_to_list", (DL_FUNC) &_mxsem_handle_to_list, 1},
+    {"_mxsem_register_module_rcpp", (DL_FUNC) &_mxsem_register_module_rcpp, 2},
+    {"_mxsem_registered_modules_rcpp", (DL_FUNC) &_mxsem_registered_modules_rcpp, 0},
+    {"_mxsem_clear_modules_rcpp", (DL_FUNC) &_mxsem_clear_modules_rcpp, 0},
+    {"_mxsem_observed_moments_rcpp", (DL_FUNC) &_mxsem_observed_moments_rcpp, 2},
+    {"_mxsem_clear_moment_cache_rcpp", (DL_FUNC) &_mxsem_clear_moment_cache_rcpp, 0},
+    {"_mxsem_optimize_algebras_rcpp", (DL_FUNC) &_mxsem_optimize_algebras_rcpp, 4},
+    {"_mxsem_pack_algebras_rcpp", (DL_FUNC) &_mxsem_pack_algebras_rcpp, 3},
+    {"_mxsem_parameter_tables_rcpp", (DL_FUNC) &_mxsem_parameter_tables_rcpp, 8},
+    {"_mxsem_parameter_table_from_partable_rcpp", (DL_FUNC) &_mxsem_parameter_table_from_partable_rcpp, 12},
+    {"_mxsem_person_fit_rcpp", (DL_FUNC) &_mxsem_person_fit_rcpp, 4},
+    {"_mxsem_ram_structure_rcpp", (DL_FUNC) &_mxsem_ram_structure_rcpp, 4},
     {"_mxsem_split_string_all", (DL_FUNC) &_mxsem_split_string_all, 2},
     {NULL, NULL, 0}
 };
@@ -0,0 +1,310 @@
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include "add_elements.h"
+#include "check_syntax.h"
+#include "diagnostics.h"
+#include "groups.h"
+#include "scan.h"
+#include "string_operations.h"
+
+// A bound (e.g., a > 0) applies to
+// 1. all parameters with the label a,
+// 2. all parameters with a label matching a pattern (e.g., lambda_* > 0), or
+// 3. all free parameters of a category (e.g., variances(manifest) > 0).
+// Bounds on labels take precedence over bounds on patterns, which take
+// precedence over bounds on categories. The labels are resolved with an index
+// of all labels and the categories with an index of all rows. Patterns are
+// matched against the labels sorted by their first characters or, for patterns
+// that start with * (e.g., *_var), by their last characters. Only patterns
+// with * at both ends (e.g., *var*) are compared with every label.
+
+static bool is_label_char(const char c){
+  return(is_char_class(c, cc_letter | cc_digit) || (c == '_') || (c == '.'));
+}
+
+bool is_bound_pattern(std::string_view lhs){
+  // anything else (e.g., a+b) is not a pattern and must be a label. Digits
+  // are label characters, so 2*b is a pattern (see is_ambiguous_pattern)
+  return((lhs.find('*') != std::string_view::npos) &&
+         std::all_of(lhs.begin(), lhs.end(), [](const char c){
+           return(is_label_char(c) || (c == '*'));
+         }));
+}
+
+bool is_pattern_bound(std::string_view equation){
+  const std::size_t op = equation.find_first_of("<>");
+  return((op != std::string_view::npos) && is_bound_pattern(equation.substr(0, op)));
+}
+
+bool is_ambiguous_pattern(std::string_view pattern){
+  for(std::size_t i = 1; i + 1 < pattern.size(); i++){
+    if((pattern[i] == '*') && is_label_char(pattern[i - 1]) && is_label_char(pattern[i + 1]))
+      return(true);
+  }
+  return(false);
+}
+
+bool is_bound_category(std::string_view lhs){
+  return(lhs.find('(') != std::string_view::npos);
+}
+
+bool matches_pattern(std::string_view pattern, std::string_view label){
+  // * matches any sequence of characters. On a mismatch, the last * is
+  // extended by one character.
+  std::size_t p = 0, l = 0;
+  std::size_t star = std::string_view::npos, star_label = 0;
+  while(l < label.size()){
+    if((p < pattern.size()) && (pattern[p] == '*')){
+      star = p++;
+      star_label = l;
+    }else if((p < pattern.size()) && (pattern[p] == label[l])){
+      p++;
+      l++;
+    }else if(star != std::string_view::npos){
+      p = star + 1;
+      l = ++star_label;
+    }else{
+      return(false);
+    }
+  }
+  while((p < pattern.size()) && (pattern[p] == '*'))
+    p++;
+  return(p == pattern.size());
+}
+
+bound_category parse_bound_category(std::string_view lhs){
+  static constexpr std::string_view element_names[] = {"loadings", "regressions", "intercepts",
+                                                       "variances", "covariances"};
+  static constexpr std::string_view variable_names[] = {"", "manifest", "latent"};
+
+  const std::size_t open = lhs.find('(');
+  if((lhs.back() != ')') || (lhs.find('(', open + 1) != std::string_view::npos))
+    parse_stop("Could not parse the bound on " + std::string(lhs) +
+      ". Categories of parameters are specified as category(variables) (e.g., variances(manifest)).");
+  const std::string_view elements = lhs.substr(0, open);
+  const std::string_view variables = lhs.substr(open + 1, lhs.size() - open - 2);
+
+  bound_category category;
+  const auto element = std::find(std::begin(element_names), std::end(element_names), elements);
+  if(element == std::end(element_names))
+    parse_stop("Unknown category " + std::string(elements) + " in the bound on " + std::string(lhs) +
+      ". Supported are loadings, regressions, intercepts, variances, and covariances.");
+  category.elements = static_cast<element_category>(element - std::begin(element_names));
+
+  const auto variable = std::find(std::begin(variable_names), std::end(variable_names), variables);
+  if(variable == std::end(variable_names))
+    parse_stop("Unknown variables " + std::string(variables) + " in the bound on " + std::string(lhs) +
+      ". Use manifest, latent, or leave the parentheses empty for all variables.");
+  category.variables = static_cast<variable_class>(variable - std::begin(variable_names));
+  return(category);
+}
+
+struct bound_equation{
+  equation_elements elements;
+  std::string_view op;
+};
+
+// all bounds in the equations, in the order of the equations
+static std::vector<bound_equation> find_bounds(const pt_column& equations){
+  static constexpr std::string_view check_for[] = {">", "<"};
+  std::vector<bound_equation> bounds;
+  for(const pt_string& eq: equations){
+    // if this is a user specified special element in curly braces, we skip the
+    // rest
+    if(eq[0] == '{')
+      continue;
+    for(std::string_view c_for: check_for){
+      if(eq.find(c_for) != std::string::npos)
+        bounds.push_back({split_string_once(eq, c_for), c_for});
+    }
+  }
+  return(bounds);
+}
+
+static void set_bound(parameter_table& pt,
+                      const std::size_t row,
+                      const bound_equation& bound){
+  if(bound.op.compare(">") == 0)
+    pt.lbound.at(row) = bound.elements.rhs;
+  else
+    pt.ubound.at(row) = bound.elements.rhs;
+}
+
+// a parameter with this label; group is the element of a group specific
+// modifier or npos if the label applies to all groups.
+struct label_reference{
+  std::size_t row;
+  std::size_t group;
+};
+
+void add_bounds(const pt_column& equations,
+                parameter_table& pt,
+                std::size_t group){
+
+  const std::vector<bound_equation> bounds = find_bounds(equations);
+  if(bounds.empty())
+    return;
+
+  // the keys are views into the modifiers, which are not changed here
+  std::unordered_map<std::string_view, std::vector<label_reference>> labels;
+  for(std::size_t i = 0; i < pt.modifier.size(); i++){
+    if(is_group_modifier(pt.modifier.at(i))){
+      // the bound only applies to the groups in which the parameter
+      // has this label
+      std::pmr::vector<std::string_view> elements = group_modifier_elements(pt.modifier.at(i),
+                                                                            pt.resource());
+      for(std::size_t g = 0; g < elements.size(); g++)
+        labels[elements.at(g)].push_back({i, g});
+    }else if(!pt.modifier.at(i).empty()){
+      labels[pt.modifier.at(i)].push_back({i, std::string_view::npos});
+    }
+  }
+
+  auto apply = [&](const std::vector<label_reference>& references, const bound_equation& bound){
+    for(const label_reference& reference: references){
+      if((reference.group == std::string_view::npos) || (reference.group == group))
+        set_bound(pt, reference.row, bound);
+    }
+  };
+
+  // patterns are matched against the sorted labels and only visit the labels
+  // with the characters before the first * (e.g., lambda_*). Patterns that
+  // start with * (e.g., *_var) visit the labels with the characters after the
+  // last * in an index of the reversed labels.
+  std::vector<std::string_view> sorted_labels;
+  std::vector<std::pair<std::string, std::string_view>> reversed_labels;
+  for(const bound_equation& bound: bounds){
+    const std::string_view pattern = bound.elements.lhs;
+    if(!is_bound_pattern(pattern) || is_bound_category(pattern))
+      continue;
+
+    bool was_found = false;
+    auto visit = [&](std::string_view label){
+      if(!matches_pattern(pattern, label))
+        return;
+      was_found = true;
+      apply(labels.at(label), bound);
+    };
+
+    const std::string_view prefix = pattern.substr(0, pattern.find('*'));
+    const std::string_view suffix = pattern.substr(pattern.rfind('*') + 1);
+    if(prefix.empty() && !suffix.empty()){
+      if(reversed_labels.empty()){
+        for(const auto& label: labels)
+          reversed_labels.emplace_back(std::string(label.first.rbegin(), label.first.rend()), label.first);
+        std::sort(reversed_labels.begin(), reversed_labels.end());
+      }
+      const std::string reversed_suffix(suffix.rbegin(), suffix.rend());
+      for(auto label = std::lower_bound(reversed_labels.begin(), reversed_labels.end(), reversed_suffix,
+                                        [](const auto& entry, const std::string& value){
+                                          return(entry.first < value);
+                                        });
+          (label != reversed_labels.end()) && (label->first.compare(0, reversed_suffix.size(), reversed_suffix) == 0);
+          label++)
+        visit(label->second);
+    }else{
+      if(sorted_labels.empty()){
+        for(const auto& label: labels)
+          sorted_labels.push_back(label.first);
+        std::sort(sorted_labels.begin(), sorted_labels.end());
+      }
+      for(auto label = std::lower_bound(sorted_labels.begin(), sorted_labels.end(), prefix);
+          (label != sorted_labels.end()) && (label->compare(0, prefix.size(), prefix) == 0);
+          label++)
+        visit(*label);
+    }
+    if(!was_found && is_ambiguous_pattern(pattern))
+      parse_stop("Found a constraint on the following parameter: " + std::string(pattern) +
+        ", but could not find this parameter in your model. Patterns with * between two " +
+        "characters (e.g., b*c) must match at least one label.");
+    if(!was_found)
+      parse_warning("The bound on " + std::string(pattern) + " does not match the label of any parameter.");
+  }
+
+  for(const bound_equation& bound: bounds){
+    if(is_bound_pattern(bound.elements.lhs) || is_bound_category(bound.elements.lhs))
+      continue;
+    auto references = labels.find(bound.elements.lhs);
+    if(references == labels.end())
+      parse_stop("Found a constraint on the following parameter: " + std::string(bound.elements.lhs) +
+        ", but could not find this parameter in your model.");
+    apply(references->second, bound);
+  }
+}
+
+// category of a row of the parameter table and the variables that must
+// belong to the class (e.g., manifest) of a bound
+static element_category row_category(const parameter_table& pt,
+                                     const std::size_t row,
+                                     std::string_view& first,
+                                     std::string_view& second){
+  const pt_string& op = pt.op.at(row);
+  first = pt.lhs.at(row);
+  second = pt.rhs.at(row);
+  if(op.compare("=~") == 0){
+    // the indicator
+    first = second;
+    return(element_category::loadings);
+  }
+  if(op.compare("~") == 0){
+    // the dependent variable
+    second = first;
+    return(pt.rhs.at(row).compare("1") == 0 ? element_category::intercepts : element_category::regressions);
+  }
+  return(first.compare(second) == 0 ? element_category::variances : element_category::covariances);
+}
+
+void add_category_bounds(const pt_column& equations,
+                         parameter_table& pt){
+
+  std::vector<bound_equation> bounds = find_bounds(equations);
+  bounds.erase(std::remove_if(bounds.begin(), bounds.end(), [](const bound_equation& bound){
+    return(!is_bound_category(bound.elements.lhs));
+  }), bounds.end());
+  if(bounds.empty())
+    return;
+
+  // index of the free parameters by category and class of their variables.
+  // Parameters with fixed values, definition variables, or algebras are
+  // not bounded.
+  static constexpr std::size_t n_classes = 3;
+  std::vector<std::vector<std::size_t>> categories(5 * n_classes);
+  const std::unordered_set<std::string_view> manifests(pt.vars.manifests.begin(), pt.vars.manifests.end());
+  const std::unordered_set<std::string_view> algebras(pt.alg.lhs.begin(), pt.alg.lhs.end());
+  for(std::size_t i = 0; i < pt.lhs.size(); i++){
+    const pt_string& modifier = pt.modifier.at(i);
+    if(!modifier.empty() &&
+       (is_number(modifier) || (modifier.rfind("data.", 0) == 0) || (algebras.count(modifier) > 0)))
+      continue;
+    std::string_view first, second;
+    const std::size_t category = static_cast<std::size_t>(row_category(pt, i, first, second));
+    categories.at(category * n_classes).push_back(i);
+    const bool first_is_manifest = manifests.count(first) > 0;
+    if(first_is_manifest == (manifests.count(second) > 0))
+      categories.at(category * n_classes +
+        static_cast<std::size_t>(first_is_manifest ? variable_class::manifest : variable_class::latent)).push_back(i);
+  }
+
+  // rows whose bound was set by a category; later categories replace these
+  std::vector<char> lower_from_category(pt.lhs.size(), 0);
+  std::vector<char> upper_from_category(pt.lhs.size(), 0);
+  for(const bound_equation& bound: bounds){
+    const bound_category category = parse_bound_category(bound.elements.lhs);
+    const std::vector<std::size_t>& rows = categories.at(static_cast<std::size_t>(category.elements) * n_classes +
+                                                          static_cast<std::size_t>(category.variables));
+    if(rows.empty())
+      parse_warning("The bound on " + std::string(bound.elements.lhs) + " does not match any parameter.");
+    const bool is_lower = bound.op.compare(">") == 0;
+    std::vector<char>& from_category = is_lower ? lower_from_category : upper_from_category;
+    for(const std::size_t row: rows){
+      // bounds on labels and patterns take precedence
+      const pt_string& current = is_lower ? pt.lbound.at(row) : pt.ubound.at(row);
+      if(current.empty() || from_category.at(row)){
+        set_bound(pt, row, bound);
+        from_category.at(row) = 1;
+      }
+    }
+  }
+}
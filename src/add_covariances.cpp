@@ -1,19 +1,19 @@
 #include "add_elements.h"
 
-void add_covariances(std::vector<std::string> variables,
-                     parameter_table& pt){
+pt_column find_exogenous(const pt_column& variables,
+                         const parameter_table& pt){
 
-  std::vector<std::string> exogenous;
+  pt_column exogenous(pt.resource());
 
   bool is_exogenous = true;
   // now, we want to check of the variables are exogenous
-  for(std::string var: variables){
+  for(const pt_string& var: variables){
     is_exogenous = true;
     for(unsigned int i = 0; i < pt.rhs.size(); i++){
 
-      const std::string& lhs_var = pt.lhs.at(i);
-      const std::string& op = pt.op.at(i);
-      const std::string& rhs_var = pt.rhs.at(i);
+      const pt_string& lhs_var = pt.lhs.at(i);
+      const pt_string& op = pt.op.at(i);
+      const pt_string& rhs_var = pt.rhs.at(i);
 
       if(op.compare("=~") == 0){
         // we are checking a loading. In this case, the predictor is on the
@@ -37,10 +37,18 @@ void add_covariances(std::vector<std::string> variables,
     }
 
     if(is_exogenous){
-      exogenous.push_back(var);
+      exogenous.emplace_back(var);
     }
   }
 
+  return(exogenous);
+}
+
+void add_covariances(const pt_column& variables,
+                     parameter_table& pt){
+
+  const pt_column exogenous = find_exogenous(variables, pt);
+
   // no covariances
   if(exogenous.size() <= 1)
     return;
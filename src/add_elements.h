@@ -2,24 +2,71 @@
 #define ADD_ELEMENTS_H
 #include "parameter_table.h"
 #include <Rcpp.h>
+#include <string_view>
+#include <unordered_set>
 
 void add_variances(parameter_table& pt);
 void add_intercepts(parameter_table& pt);
-void add_covariances(std::vector<std::string> variables,
+void add_covariances(const pt_column& variables,
                      parameter_table& pt);
 
-inline void add_unique(std::vector<std::string>& where_to_add, const std::vector<std::string>& what_to_add){
-  bool variable_exists = false;
-  for(unsigned int i = 0; i < what_to_add.size(); i++){
-    variable_exists = false;
-    for(unsigned int j = 0; j < where_to_add.size(); j++){
-      if(what_to_add.at(i).compare(where_to_add.at(j)) == 0){
-        variable_exists = true;
-        break;
-      }
-    }
-    if(!variable_exists){
-      where_to_add.push_back(what_to_add.at(i));
+// bounds on labels, patterns of labels (e.g., lambda_* > 0), and categories
+// of parameters (e.g., variances(manifest) > 0); see add_bounds.cpp.
+// add_bounds sets the bounds on labels and patterns for one group.
+// add_category_bounds must be called once all automatically added elements
+// are in the table.
+enum class element_category{loadings, regressions, intercepts, variances, covariances};
+enum class variable_class{any, manifest, latent};
+
+struct bound_category{
+  element_category elements;
+  variable_class variables;
+};
+
+// patterns consist of the characters of labels and *
+bool is_bound_pattern(std::string_view lhs);
+// bounds on patterns may start with * (e.g., *_var > 0); all other equations
+// start with a name
+bool is_pattern_bound(std::string_view equation);
+// a pattern such as b*c could also be a mistyped product of labels and must
+// match at least one label
+bool is_ambiguous_pattern(std::string_view pattern);
+bool is_bound_category(std::string_view lhs);
+bool matches_pattern(std::string_view pattern, std::string_view label);
+// parses category(variables); throws if the category or variables are unknown
+bound_category parse_bound_category(std::string_view lhs);
+
+void add_bounds(const pt_column& equations,
+                parameter_table& pt,
+                std::size_t group);
+void add_category_bounds(const pt_column& equations,
+                         parameter_table& pt);
+
+// equality constraints (e.g., a == b == c) are resolved into shared labels;
+// see add_equalities.cpp. Must be called once the algebras are known.
+bool is_equality(std::string_view equation);
+// splits a == b == c into its elements; throws if an element is neither a
+// label nor a value
+std::vector<std::string_view> split_equality(std::string_view equation);
+void add_equalities(const pt_column& equations,
+                    parameter_table& pt);
+
+// returns the variables that are neither indicators (rhs of =~) nor outcomes
+// of a regression (lhs of ~)
+pt_column find_exogenous(const pt_column& variables,
+                         const parameter_table& pt);
+
+// adds the elements of what_to_add that are not yet in where_to_add, in the
+// order of their first occurrence. The lookup uses a hash set so that large
+// models do not need a comparison with every element.
+inline void add_unique(pt_column& where_to_add, const pt_column& what_to_add){
+  // the set holds views into where_to_add; it must not reallocate
+  where_to_add.reserve(where_to_add.size() + what_to_add.size());
+  std::unordered_set<std::string_view> existing(where_to_add.begin(), where_to_add.end());
+  for(const pt_string& element: what_to_add){
+    if(existing.count(element) == 0){
+      where_to_add.emplace_back(element);
+      existing.insert(where_to_add.back());
     }
   }
 }
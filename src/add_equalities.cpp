@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include "add_elements.h"
+#include "diagnostics.h"
+#include "scan.h"
+#include "string_operations.h"
+
+// Equality constraints (e.g., a == b == c) are not passed to OpenMx as
+// mxConstraints. Instead, all parameters in a chain of equalities get the same
+// label, so OpenMx estimates a single parameter with the unconstrained
+// optimizer. Chains that share a label (a == b; b == c) are merged with a
+// union-find. If a chain contains a value (a == b == 1), all its parameters
+// are fixed to this value.
+
+bool is_equality(std::string_view equation){
+  return((equation[0] != '{') &&
+         (equation[0] != '!') &&
+         (equation.find("==") != std::string_view::npos) &&
+         (equation.find(":=") == std::string_view::npos) &&
+         (equation.find('~') == std::string_view::npos));
+}
+
+std::vector<std::string_view> split_equality(std::string_view equation){
+  std::vector<std::string_view> elements;
+  std::size_t start = 0;
+  for(std::size_t at = equation.find("=="); at != std::string_view::npos; at = equation.find("==", start)){
+    elements.push_back(equation.substr(start, at - start));
+    start = at + 2;
+  }
+  elements.push_back(equation.substr(start));
+
+  for(std::string_view element: elements){
+    if(element.empty() || (element.find('=') != std::string_view::npos))
+      parse_stop("Could not parse the equality constraint " + std::string(equation) +
+        ". Equality constraints are specified as a == b or a == b == c.");
+    if(!is_number(element) &&
+       !std::all_of(element.begin(), element.end(), [](const char c){
+         return(is_char_class(c, cc_letter | cc_digit) || (c == '_') || (c == '.'));
+       }))
+      parse_stop("Could not parse the equality constraint " + std::string(equation) +
+        ". Only labels and values can be set equal.");
+  }
+  return(elements);
+}
+
+// union-find over the elements of all equalities; the root of each set is
+// the element that was found first
+class equality_sets{
+public:
+  std::size_t index(std::string_view element){
+    auto found = indices.emplace(element, elements.size());
+    if(found.second){
+      elements.push_back(element);
+      parents.push_back(parents.size());
+    }
+    return(found.first->second);
+  }
+
+  std::size_t find(std::size_t i){
+    while(parents[i] != i){
+      parents[i] = parents[parents[i]];
+      i = parents[i];
+    }
+    return(i);
+  }
+
+  void merge(std::size_t i, std::size_t j){
+    i = find(i);
+    j = find(j);
+    if(i < j)
+      parents[j] = i;
+    else
+      parents[i] = j;
+  }
+
+  std::unordered_map<std::string_view, std::size_t> indices;
+  std::vector<std::string_view> elements;
+  std::vector<std::size_t> parents;
+};
+
+// calls on_name for each name in an algebra and on_other for all characters
+// in between. Names start with a letter; everything else is a number (e.g., 1e5)
+template<class name_function, class other_function>
+static void for_each_name(std::string_view expression,
+                          name_function on_name,
+                          other_function on_other){
+  auto is_name_char = [](const char c){
+    return(is_char_class(c, cc_letter | cc_digit) || (c == '_') || (c == '.'));
+  };
+  std::size_t i = 0;
+  while(i < expression.size()){
+    if(!is_name_char(expression[i])){
+      on_other(expression.substr(i++, 1));
+      continue;
+    }
+    const std::size_t start = i;
+    while((i < expression.size()) && is_name_char(expression[i]))
+      i++;
+    const std::string_view name = expression.substr(start, i - start);
+    if(is_char_class(name[0], cc_letter))
+      on_name(name);
+    else
+      on_other(name);
+  }
+}
+
+// replaces all names in an algebra that were merged into another label
+static pt_string replace_names(const pt_string& expression,
+                               const std::unordered_map<std::string_view, std::string_view>& replace,
+                               std::pmr::memory_resource* mr){
+  pt_string replaced(mr);
+  auto append = [&](std::string_view other){
+    replaced += other;
+  };
+  for_each_name(expression, [&](std::string_view name){
+    auto found = replace.find(name);
+    if(found == replace.end()){
+      replaced += name;
+    }else if(is_number(found->second)){
+      replaced += '(';
+      replaced += found->second;
+      replaced += ')';
+    }else{
+      replaced += found->second;
+    }
+  }, append);
+  return(replaced);
+}
+
+// an algebra that is set equal to an element it depends on (e.g., d := b + c
+// and d == c) would refer to itself once the element is replaced with the
+// label of the algebra. Such equalities are nonlinear constraints and cannot
+// be expressed with shared labels.
+static void check_circular_algebras(const parameter_table& pt,
+                                    const std::unordered_map<std::string_view, std::string_view>& replace){
+  std::unordered_map<std::string_view, std::size_t> algebra_rows;
+  for(std::size_t i = 0; i < pt.alg.lhs.size(); i++)
+    algebra_rows.emplace(pt.alg.lhs.at(i), i);
+
+  for(std::size_t a = 0; a < pt.alg.lhs.size(); a++){
+    const std::string_view label = pt.alg.lhs.at(a);
+    // depth first search over the algebras this algebra depends on
+    std::vector<std::size_t> open = {a};
+    std::vector<char> visited(pt.alg.lhs.size(), 0);
+    visited.at(a) = 1;
+    while(!open.empty()){
+      const std::size_t current = open.back();
+      open.pop_back();
+      for_each_name(pt.alg.rhs.at(current), [&](std::string_view name){
+        auto found = replace.find(name);
+        if((found != replace.end()) && (found->second == label))
+          parse_stop("Cannot set " + std::string(name) + " equal to the algebra " + std::string(label) +
+            " because the algebra depends on " + std::string(name) +
+            ". Use an mxConstraint for such nonlinear constraints.");
+        auto row = algebra_rows.find(name);
+        if((row != algebra_rows.end()) && !visited.at(row->second)){
+          visited.at(row->second) = 1;
+          open.push_back(row->second);
+        }
+      }, [](std::string_view){});
+    }
+  }
+}
+
+void add_equalities(const pt_column& equations,
+                    parameter_table& pt){
+
+  equality_sets sets;
+  for(const pt_string& eq: equations){
+    if(!is_equality(eq))
+      continue;
+    const std::vector<std::string_view> elements = split_equality(eq);
+    const std::size_t first = sets.index(elements.at(0));
+    for(std::size_t e = 1; e < elements.size(); e++)
+      sets.merge(first, sets.index(elements.at(e)));
+  }
+  if(sets.elements.empty())
+    return;
+
+  const std::unordered_set<std::string_view> modifiers(pt.modifier.begin(), pt.modifier.end());
+  const std::unordered_set<std::string_view> new_parameters(pt.alg.new_parameters.begin(),
+                                                            pt.alg.new_parameters.end());
+  const std::unordered_set<std::string_view> algebras(pt.alg.lhs.begin(), pt.alg.lhs.end());
+
+  // the label of each set: a value, the result of an algebra, a definition
+  // variable, or the label that was found first. Two of the former
+  // in one set cannot be equal.
+  std::vector<std::string_view> labels(sets.elements.size());
+  auto is_fixed = [&](std::string_view element){
+    return(is_number(element) || (algebras.count(element) > 0) || (element.rfind("data.", 0) == 0));
+  };
+  for(std::size_t i = 0; i < sets.elements.size(); i++){
+    const std::string_view element = sets.elements.at(i);
+    if(!is_number(element) && (element.rfind("data.", 0) != 0) &&
+       (modifiers.count(element) == 0) && (new_parameters.count(element) == 0) &&
+       (algebras.count(element) == 0))
+      parse_stop("Found an equality constraint on the following parameter: " + std::string(element) +
+        ", but could not find this parameter in your model.");
+
+    std::string_view& label = labels.at(sets.find(i));
+    if(label.empty() || (!is_fixed(label) && is_fixed(element))){
+      label = element;
+    }else if(is_fixed(label) && is_fixed(element) &&
+             !(is_number(label) && is_number(element) && (std::stod(std::string(label)) == std::stod(std::string(element))))){
+      parse_stop("Cannot set " + std::string(label) + " and " + std::string(element) +
+        " equal. Equality constraints can only fix parameters to one value, algebra, or definition variable.");
+    }
+  }
+
+  std::unordered_map<std::string_view, std::string_view> replace;
+  std::unordered_set<std::string_view> shared_labels;
+  for(std::size_t i = 0; i < sets.elements.size(); i++){
+    const std::string_view label = labels.at(sets.find(i));
+    if(sets.elements.at(i) != label){
+      replace.emplace(sets.elements.at(i), label);
+      shared_labels.insert(label);
+    }
+  }
+  if(replace.empty())
+    return;
+
+  check_circular_algebras(pt, replace);
+
+  // the strings in replace are views into the equations, which are not
+  // changed here
+  for(std::size_t i = 0; i < pt.modifier.size(); i++){
+    auto found = replace.find(pt.modifier.at(i));
+    if(found == replace.end())
+      continue;
+    if(algebras.count(found->second) > 0)
+      pt.free.at(i) = "FALSE";
+    pt.modifier.at(i) = found->second;
+  }
+
+  // all parameters with the same label must have the same bounds
+  std::unordered_map<std::string_view, std::size_t> first_row;
+  for(std::size_t i = 0; i < pt.modifier.size(); i++){
+    if(shared_labels.count(pt.modifier.at(i)) == 0)
+      continue;
+    auto first = first_row.emplace(pt.modifier.at(i), i).first->second;
+    for(pt_column* bound: {&pt.lbound, &pt.ubound}){
+      pt_string& first_bound = bound->at(first);
+      pt_string& row_bound = bound->at(i);
+      if(first_bound.empty())
+        first_bound = row_bound;
+      else if(!row_bound.empty() && (row_bound != first_bound))
+        parse_stop("The parameters set equal to " + std::string(pt.modifier.at(i)) +
+          " have different bounds (" + std::string(first_bound) + " and " + std::string(row_bound) + ").");
+    }
+  }
+  for(std::size_t i = 0; i < pt.modifier.size(); i++){
+    auto first = first_row.find(pt.modifier.at(i));
+    if(first == first_row.end())
+      continue;
+    pt.lbound.at(i) = pt.lbound.at(first->second);
+    pt.ubound.at(i) = pt.ubound.at(first->second);
+  }
+
+  // new parameters that were merged into another label are no longer needed;
+  // the algebras refer to the shared label instead
+  std::size_t kept = 0;
+  for(std::size_t i = 0; i < pt.alg.new_parameters.size(); i++){
+    if(replace.count(pt.alg.new_parameters.at(i)) > 0)
+      continue;
+    if(kept != i){
+      pt.alg.new_parameters.at(kept) = std::move(pt.alg.new_parameters.at(i));
+      pt.alg.new_parameters_free.at(kept) = std::move(pt.alg.new_parameters_free.at(i));
+    }
+    kept++;
+  }
+  pt.alg.new_parameters.resize(kept);
+  pt.alg.new_parameters_free.resize(kept);
+
+  for(pt_string& rhs: pt.alg.rhs)
+    rhs = replace_names(rhs, replace, pt.resource());
+}
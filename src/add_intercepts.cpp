@@ -4,7 +4,7 @@
 
 void add_intercepts(parameter_table& pt){
 
-  std::vector<std::string> manifests = pt.vars.manifests;
+  const pt_column& manifests = pt.vars.manifests;
 
   bool has_intercept = false;
   for(unsigned int i = 0; i < manifests.size(); i++){
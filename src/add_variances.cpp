@@ -2,7 +2,7 @@
 
 void add_variances(parameter_table& pt){
 
-  std::vector<std::string> variables;
+  pt_column variables(pt.resource());
   add_unique(variables, pt.lhs);
   add_unique(variables, pt.rhs);
 
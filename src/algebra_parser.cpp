@@ -0,0 +1,306 @@
+#include <Rcpp.h>
+#include <cstdio>
+#include <cstdlib>
+#include "algebra_parser.h"
+#include "scan.h"
+
+bool is_symbol_char(const char c){
+  return(is_char_class(c, cc_letter | cc_digit) || c == '_' || c == '.');
+}
+
+bool is_valid_symbol(std::string_view name){
+  if(name.empty() || !(is_char_class(name[0], cc_letter) || name[0] == '.'))
+    return(false);
+  for(char c: name){
+    if(!is_symbol_char(c))
+      return(false);
+  }
+  return(true);
+}
+
+int binary_precedence(std::string_view op){
+  if(op == "|" || op == "||")
+    return(1);
+  if(op == "&" || op == "&&")
+    return(2);
+  if(op == "<" || op == ">" || op == "<=" || op == ">=" || op == "==" || op == "!=")
+    return(4);
+  if(op == "+" || op == "-")
+    return(5);
+  if(op == "*" || op == "/")
+    return(6);
+  if(op.size() > 1 && op.front() == '%' && op.back() == '%')
+    return(7);
+  if(op == ":")
+    return(8);
+  if(op == "^")
+    return(10);
+  return(-1);
+}
+
+static const int not_precedence   = 3;
+static const int unary_precedence = 9;
+static const int atomic_precedence = 100;
+
+std::string format_number(const double value){
+  char buffer[32];
+  for(int precision = 15; precision <= 17; precision++){
+    std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+    if(std::strtod(buffer, nullptr) == value)
+      break;
+  }
+  return(std::string(buffer));
+}
+
+int algebra_parser::parse(std::string_view expression){
+  if(!tokenize(expression))
+    return(-1);
+  position = 0;
+  int root = parse_expression(0);
+  if(root < 0 || position != tokens.size())
+    return(-1);
+  return(root);
+}
+
+std::vector<std::string_view> algebra_parser::symbols(std::string_view code){
+  std::vector<std::string_view> found;
+  std::size_t i = 0;
+  while(i < code.size()){
+    if(!is_symbol_char(code[i])){
+      i++;
+      continue;
+    }
+    std::size_t start = i;
+    while(i < code.size() && is_symbol_char(code[i]))
+      i++;
+    found.push_back(code.substr(start, i - start));
+  }
+  return(found);
+}
+
+bool algebra_parser::tokenize(std::string_view expression){
+  static constexpr std::string_view two_char_ops[] = {"<=", ">=", "==", "!=", "&&", "||"};
+  tokens.clear();
+  std::size_t i = 0;
+  while(i < expression.size()){
+    const char c = expression[i];
+    if(is_char_class(c, cc_whitespace) || c == '\n'){
+      i++;
+      continue;
+    }
+    const std::size_t start = i;
+    if(is_char_class(c, cc_digit) ||
+       (c == '.' && i + 1 < expression.size() && is_char_class(expression[i + 1], cc_digit))){
+      while(i < expression.size() && (is_char_class(expression[i], cc_digit) || expression[i] == '.'))
+        i++;
+      if(i < expression.size() && (expression[i] == 'e' || expression[i] == 'E')){
+        i++;
+        if(i < expression.size() && (expression[i] == '+' || expression[i] == '-'))
+          i++;
+        if(i == expression.size() || !is_char_class(expression[i], cc_digit))
+          return(false);
+        while(i < expression.size() && is_char_class(expression[i], cc_digit))
+          i++;
+      }
+      tokens.push_back({token_type::number, expression.substr(start, i - start)});
+      continue;
+    }
+    if(is_char_class(c, cc_letter) || c == '.' || c == '_'){
+      while(i < expression.size() && is_symbol_char(expression[i]))
+        i++;
+      tokens.push_back({token_type::symbol, expression.substr(start, i - start)});
+      continue;
+    }
+    if(c == '%'){
+      const std::size_t end = expression.find('%', i + 1);
+      if(end == std::string_view::npos)
+        return(false);
+      i = end + 1;
+      tokens.push_back({token_type::op, expression.substr(start, i - start)});
+      continue;
+    }
+    bool found_two_char_op = false;
+    for(std::string_view op: two_char_ops){
+      if(expression.substr(i, 2) == op){
+        tokens.push_back({token_type::op, op});
+        i += 2;
+        found_two_char_op = true;
+        break;
+      }
+    }
+    if(found_two_char_op)
+      continue;
+    if(std::string_view("+-*/^<>!&|:()[],").find(c) == std::string_view::npos)
+      return(false);
+    tokens.push_back({token_type::op, expression.substr(i, 1)});
+    i++;
+  }
+  return(true);
+}
+
+bool algebra_parser::next_is(std::string_view op) const{
+  return(position < tokens.size() &&
+         tokens[position].type == token_type::op &&
+         tokens[position].text == op);
+}
+
+int algebra_parser::add_node(node_type type, std::string_view text, std::vector<int> children){
+  nodes.push_back({type, std::string(text), std::move(children)});
+  return(static_cast<int>(nodes.size()) - 1);
+}
+
+int algebra_parser::parse_expression(const int min_precedence){
+  int left = parse_unary();
+  while(left >= 0 && position < tokens.size() && tokens[position].type == token_type::op){
+    std::string_view op = tokens[position].text;
+    const int precedence = binary_precedence(op);
+    if(precedence < 0 || precedence < min_precedence)
+      break;
+    position++;
+    // ^ is the only right associative operator
+    int right = parse_expression(op == "^" ? precedence : precedence + 1);
+    if(right < 0)
+      return(-1);
+    left = add_node(node_type::binary, op, {left, right});
+  }
+  return(left);
+}
+
+int algebra_parser::parse_unary(){
+  if(next_is("-") || next_is("+") || next_is("!")){
+    std::string_view op = tokens[position++].text;
+    int operand = parse_expression(op == "!" ? not_precedence : unary_precedence);
+    if(operand < 0)
+      return(-1);
+    return(add_node(node_type::unary, op, {operand}));
+  }
+  return(parse_postfix(parse_primary()));
+}
+
+int algebra_parser::parse_primary(){
+  if(position == tokens.size())
+    return(-1);
+  const token& current = tokens[position++];
+  switch(current.type){
+  case token_type::number:
+    return(add_node(node_type::number, current.text));
+  case token_type::symbol:
+    if(next_is("(")){
+      position++;
+      std::vector<int> arguments;
+      if(!parse_arguments(")", false, arguments))
+        return(-1);
+      return(add_node(node_type::call, current.text, std::move(arguments)));
+    }
+    return(add_node(node_type::symbol, current.text));
+  case token_type::op:
+    if(current.text == "("){
+      int inner = parse_expression(0);
+      if(inner < 0 || !next_is(")"))
+        return(-1);
+      position++;
+      return(inner);
+    }
+    return(-1);
+  }
+  return(-1);
+}
+
+int algebra_parser::parse_postfix(int object){
+  while(object >= 0 && next_is("[")){
+    position++;
+    std::vector<int> children = {object};
+    if(!parse_arguments("]", true, children))
+      return(-1);
+    object = add_node(node_type::index, "[", std::move(children));
+  }
+  return(object);
+}
+
+bool algebra_parser::parse_arguments(std::string_view closing, const bool allow_empty, std::vector<int>& arguments){
+  if(next_is(closing)){
+    position++;
+    return(true);
+  }
+  while(true){
+    if(allow_empty && (next_is(",") || next_is(closing))){
+      // empty index; represented by an empty symbol
+      arguments.push_back(add_node(node_type::symbol, ""));
+    }else{
+      int argument = parse_expression(0);
+      if(argument < 0)
+        return(false);
+      arguments.push_back(argument);
+    }
+    if(next_is(closing)){
+      position++;
+      return(true);
+    }
+    if(!next_is(","))
+      return(false);
+    position++;
+  }
+}
+
+static int node_precedence(const algebra_node& node){
+  switch(node.type){
+  case node_type::number:
+    // negative values from constant folding behave like a unary minus
+    return(node.text[0] == '-' ? unary_precedence : atomic_precedence);
+  case node_type::unary:
+    return(node.text == "!" ? not_precedence : unary_precedence);
+  case node_type::binary:
+    return(binary_precedence(node.text));
+  default:
+    return(atomic_precedence);
+  }
+}
+
+std::string node_to_string(const std::vector<algebra_node>& nodes, const int id){
+  const algebra_node& node = nodes[id];
+  auto child = [&](const int child_id, const bool needs_parentheses){
+    std::string str = node_to_string(nodes, child_id);
+    return(needs_parentheses ? "(" + str + ")" : str);
+  };
+  auto join = [&](std::size_t from, const char* separator){
+    std::string str;
+    for(std::size_t i = from; i < node.children.size(); i++){
+      if(i > from)
+        str += separator;
+      str += node_to_string(nodes, node.children[i]);
+    }
+    return(str);
+  };
+
+  switch(node.type){
+  case node_type::number:
+  case node_type::symbol:
+    return(node.text);
+  case node_type::call:
+    return(node.text + "(" + join(0, ", ") + ")");
+  case node_type::index:
+    return(child(node.children[0], node_precedence(nodes[node.children[0]]) < atomic_precedence) +
+           "[" + join(1, ",") + "]");
+  case node_type::unary:
+    return(node.text + child(node.children[0], node_precedence(nodes[node.children[0]]) < node_precedence(node)));
+  case node_type::binary:{
+    const int precedence = binary_precedence(node.text);
+    const bool right_associative = node.text == "^";
+    const int left_precedence  = node_precedence(nodes[node.children[0]]);
+    const int right_precedence = node_precedence(nodes[node.children[1]]);
+    return(child(node.children[0], left_precedence < precedence || (right_associative && left_precedence == precedence)) +
+           " " + node.text + " " +
+           child(node.children[1], right_precedence < precedence || (!right_associative && right_precedence == precedence)));
+  }
+  }
+  return("");
+}
+
+void collect_symbols(const std::vector<algebra_node>& nodes,
+                            const int id,
+                            std::unordered_set<std::string>& symbols){
+  if(nodes[id].type == node_type::symbol)
+    symbols.insert(nodes[id].text);
+  for(int child: nodes[id].children)
+    collect_symbols(nodes, child, symbols);
+}
@@ -0,0 +1,64 @@
+#ifndef ALGEBRA_PARSER_H
+#define ALGEBRA_PARSER_H
+#include <Rcpp.h>
+#include <string_view>
+#include <unordered_set>
+
+// The algebras are parsed into a small expression tree that follows R's
+// operator precedence (mxAlgebraFromString uses R's parser). All nodes of all
+// algebras are stored in one pool and refer to their children by index.
+enum class node_type{number, symbol, unary, binary, call, index};
+
+struct algebra_node{
+  node_type type;
+  std::string text; // number literal, symbol, operator, or function name
+  std::vector<int> children;
+};
+
+class algebra_parser{
+public:
+  explicit algebra_parser(std::vector<algebra_node>& nodes):
+  nodes(nodes){}
+
+  // returns the index of the root node or -1 if the expression is not
+  // supported.
+  int parse(std::string_view expression);
+
+  // all symbols in a piece of code; used for user defined elements
+  static std::vector<std::string_view> symbols(std::string_view code);
+
+private:
+  enum class token_type{number, symbol, op};
+  struct token{
+    token_type type;
+    std::string_view text;
+  };
+
+  std::vector<algebra_node>& nodes;
+  std::vector<token> tokens;
+  std::size_t position = 0;
+
+  bool tokenize(std::string_view expression);
+  bool next_is(std::string_view op) const;
+  int add_node(node_type type, std::string_view text, std::vector<int> children = {});
+  int parse_expression(const int min_precedence);
+  int parse_unary();
+  int parse_primary();
+  // matrix elements (e.g., A[1,1] or A[1,])
+  int parse_postfix(int object);
+  bool parse_arguments(std::string_view closing, const bool allow_empty, std::vector<int>& arguments);
+};
+
+bool is_symbol_char(const char c);
+// checks if name can be used as a symbol in an algebra
+bool is_valid_symbol(std::string_view name);
+// precedence of a binary operator; -1 if op is not a binary operator
+int binary_precedence(std::string_view op);
+// shortest representation that is read back as the same value
+std::string format_number(const double value);
+std::string node_to_string(const std::vector<algebra_node>& nodes, const int id);
+void collect_symbols(const std::vector<algebra_node>& nodes,
+                     const int id,
+                     std::unordered_set<std::string>& symbols);
+
+#endif
@@ -7,11 +7,7 @@
 //' @param c character
 //' @param str string
 //' @return bool: true if char is in string
-bool char_in_string(const char c, const std::string& str) {
-  for(auto&s: str){
-    if(s  == c)
-      return(true);
-  }
-  return(false);
+bool char_in_string(const char c, std::string_view str) {
+  return(str.find(c) != std::string_view::npos);
 }
 
@@ -1,27 +1,32 @@
 #include <Rcpp.h>
+#include "add_elements.h"
 #include "string_operations.h"
 #include "clean_syntax.h"
+#include "diagnostics.h"
+#include "scan.h"
 
 //' check_cleaned
 //'
 //' checks cleaned syntax
 //' @param cleaned_syntax lavaan style syntax
 //' @return throws error in case of disallowed syntax
-void check_cleaned(const std::vector<std::string> cleaned_syntax){
+void check_cleaned(const pt_column& cleaned_syntax){
 
   // check if line starts are correct
   char cmp_to;
 
-  for(std::string s: cleaned_syntax){
+  for(const pt_string& s: cleaned_syntax){
     cmp_to = s[0];
-    if(!(isalpha(cmp_to) || // check if character
+    if(!(is_char_class(cmp_to, cc_letter) || // check if character
     (cmp_to == '_') ||
     (cmp_to == '!') ||
-    (cmp_to == '{')
+    (cmp_to == '{') ||
+    ((cmp_to == '*') && is_pattern_bound(s))
     )){
-      Rcpp::Rcout << s << std::endl;
-      Rcpp::stop("The following syntax is not allowed:" +
-        s +
+      if(!collecting_diagnostics())
+        Rcpp::Rcout << s << std::endl;
+      parse_stop("The following syntax is not allowed:" +
+        std::string(s) +
         ". Each line must start with the name of a variable (e.g., y1) or parameter (e.g., a > .4)");
     }
   }
@@ -1,71 +1,71 @@
 #include <Rcpp.h>
-#include <cctype>
 #include "check_syntax.h"
+#include "diagnostics.h"
+#include "scan.h"
 
-bool check_equation_chars(const std::string& equation){
+// Group specific modifiers (e.g., y =~ c(a1, a2)*y1) are the only elements
+// of an equation that may contain parentheses and commas. Returns the position
+// of the * following the modifier if a group specific modifier starts at
+// position and position otherwise.
+static std::size_t skip_group_modifier(std::string_view equation,
+                                       std::size_t position,
+                                       std::size_t end){
+  // the modifier must start a right hand side element
+  if((position == 0) ||
+     ((equation[position - 1] != '~') && (equation[position - 1] != '+')) ||
+     (equation.substr(position, 2).compare("c(") != 0))
+    return(position);
 
-  int n_curly_open = 0; // indicates if the user specified a block of code
-  // that should not be changed
-
-  std::vector<char> allowed_special = {
-    '_',
-    '=',
-    '~',
-    '*',
-    '+',
-    '-',
-    '.'
-  };
+  for(std::size_t i = position + 2; i < end; i++){
+    if(equation[i] == ')'){
+      if((i + 1 < end) && (equation[i + 1] == '*'))
+        return(i + 1);
+      return(position);
+    }
+    if(!is_char_class(equation[i], cc_letter | cc_digit | cc_equation) &&
+       (equation[i] != ','))
+      return(position);
+  }
+  return(position);
+}
 
-  for(char c: equation){
+std::size_t find_unsupported_char(std::string_view equation){
 
-    // check for curly braces:
-    switch(c){
-    case '{':
-      n_curly_open++;
-      break;
-    case '}':
-      n_curly_open--;
-      if(n_curly_open < 0){
-        Rcpp::stop("Error parsing the syntax: Found a closing curly brace } without an opening curly brance {. The last line was "  +
-          equation);
+  // blocks of code in curly braces are not checked
+  std::size_t unsupported = std::string_view::npos;
+  auto check_segment = [&](std::size_t start, std::size_t end){
+    for(std::size_t i = start; i < end; i++){
+      i = skip_group_modifier(equation, i, end);
+      // all letters and numbers are allowed; in addition, some special symbols
+      if(!is_char_class(equation[i], cc_letter | cc_digit | cc_equation)){
+        unsupported = i;
+        return(false);
       }
-      break;
     }
+    return(true);
+  };
 
-    if((n_curly_open != 0) | (c == '}'))
-      continue;
+  std::size_t unmatched = for_each_top_level_segment(equation, check_segment);
+  if(unmatched != std::string_view::npos)
+    return(unmatched);
 
-    // checking each character
-    if (isalpha(c) || isdigit(c)){
-      continue; // no need to check further -> all letters and numbers are allowed
-    }
+  return(unsupported);
+}
 
-    // check special symbols
-    bool is_special = false;
-    // check all special symbols
-    for(char a: allowed_special){
-      if(a == c){
-        is_special = true;
-        break;
-      }
-    }
-    if(is_special)
-      continue;
-    // neither letter/number nor allowed special character:
-    return false;
+void check_equation(std::string_view equation){
 
-  }
-  // everything was allowed:
-  return true;
-}
+  const std::size_t unsupported = find_unsupported_char(equation);
+
+  if(unsupported == std::string_view::npos)
+    return;
 
-void check_equation(const std::string equation){
+  if(equation[unsupported] == '}')
+    parse_stop("Error parsing the syntax: Found a closing curly brace } without an opening curly brance {. The last line was "  +
+      std::string(equation));
 
-  if(!check_equation_chars(equation))
-    Rcpp::stop(
-      "The following equation contains unsupported symbols: " +
-        equation + "."
-    );
+  parse_stop(
+    "The following equation contains unsupported symbols: " +
+      std::string(equation) + "."
+  );
 
 }
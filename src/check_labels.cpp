@@ -1,11 +1,14 @@
 #include <Rcpp.h>
+#include <algorithm>
 #include "check_syntax.h"
+#include "diagnostics.h"
+#include "scan.h"
 
-void check_modifier(const std::string modifier){
+void check_modifier(std::string_view modifier){
 
     if(modifier.compare("NA") == 0){
       std::string wrn = "NA found as modifier (e.g., label) for one of the parameters. ";
-      Rcpp::warning(
+      parse_warning(
         wrn +
           "Note that this does not set a loading to being freely estimated in mxsem. " +
           "Use the argument scale_loadings = FALSE to freely estimate all loadings and " +
@@ -13,3 +16,82 @@ void check_modifier(const std::string modifier){
       );
     }
 }
+
+std::size_t find_invalid_name_char(std::string_view name){
+  for(std::size_t i = 0; i < name.size(); i++){
+    if(!is_char_class(name[i], cc_letter | cc_digit) && (name[i] != '_'))
+      return(i);
+  }
+  return(std::string_view::npos);
+}
+
+bool is_valid_modifier(std::string_view modifier){
+  auto is_value_char = [](const char c){
+    return(is_char_class(c, cc_digit) || (c == '.') || (c == '-'));
+  };
+  auto is_label_char = [](const char c){
+    return(is_char_class(c, cc_letter | cc_digit) || ((c >= '.') && (c <= '_')));
+  };
+  if(std::all_of(modifier.begin(), modifier.end(), is_value_char))
+    return(true);
+  return(is_char_class(modifier[0], cc_letter) &&
+         std::all_of(modifier.begin(), modifier.end(), is_label_char));
+}
+
+bool is_valid_bound(std::string_view bound){
+  return(!bound.empty() &&
+         std::all_of(bound.begin(), bound.end(), [](const char c){
+           return(is_char_class(c, cc_digit) || (c == '.') || (c == '-'));
+         }));
+}
+
+// the columns are either columns of the parameter table or vectors from R
+template<class column>
+static void check_field_columns(const column& lhs,
+                                const column& rhs,
+                                const column& modifier,
+                                const column& lbound,
+                                const column& ubound){
+  for(std::size_t i = 0; i < lhs.size(); i++){
+    const std::string_view row_lhs = lhs[i];
+    if(row_lhs.empty() || (find_invalid_name_char(row_lhs) != std::string_view::npos))
+      parse_stop("The following left hand side does not match the allowed pattern of letters digits and underscores: " +
+        std::string(row_lhs));
+    const std::string_view row_rhs = rhs[i];
+    if(row_rhs.empty() || (find_invalid_name_char(row_rhs) != std::string_view::npos))
+      parse_stop("The following right hand side does not match the allowed pattern of letters digits and underscores: " +
+        std::string(row_rhs));
+    // modifiers in curly braces are algebras (see check_modifier_for_algebra)
+    const std::string_view row_modifier = modifier[i];
+    if(!row_modifier.empty() && (row_modifier[0] != '{') && !is_valid_modifier(row_modifier))
+      parse_stop("The following modifier is not allowed: " + std::string(row_modifier));
+    for(const std::string_view bound: {std::string_view(lbound[i]), std::string_view(ubound[i])}){
+      if(!bound.empty() && !is_valid_bound(bound))
+        parse_stop("Invalid bound " + std::string(bound) + ".");
+    }
+  }
+}
+
+void check_fields(const parameter_table& pt){
+  check_field_columns(pt.lhs, pt.rhs, pt.modifier, pt.lbound, pt.ubound);
+}
+
+//' check_fields_rcpp
+//'
+//' checks the variables, modifiers, and bounds of a parameter table with the rules
+//' that are also used by the parser and by mxsem_check.
+//' @param lhs left hand side of the parameter table
+//' @param rhs right hand side of the parameter table
+//' @param modifier modifiers of the parameter table
+//' @param lbound lower bounds of the parameter table
+//' @param ubound upper bounds of the parameter table
+//' @return nothing; throws an error for the first invalid field
+//' @keywords internal
+// [[Rcpp::export]]
+void check_fields_rcpp(const std::vector<std::string>& lhs,
+                       const std::vector<std::string>& rhs,
+                       const std::vector<std::string>& modifier,
+                       const std::vector<std::string>& lbound,
+                       const std::vector<std::string>& ubound){
+  check_field_columns(lhs, rhs, modifier, lbound, ubound);
+}
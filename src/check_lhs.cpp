@@ -1,33 +1,21 @@
 #include <Rcpp.h>
 #include "string_operations.h"
+#include "diagnostics.h"
+#include "scan.h"
 
-void check_lhs(const std::string& lhs, const std::string not_allowed){
+void check_lhs(std::string_view lhs, std::string_view not_allowed){
 
-  int n_curly_open = 0; // indicates if the user specified a block of code
-  // that should not be changed
+  // elements in curly braces are a block of code that should not be changed
+  auto disallowed_found = [&](std::size_t) -> bool {
+    parse_stop("The following is not allowed: " +
+      std::string(lhs) +
+      ". It contains one of the following characters: " +
+      std::string(not_allowed));
+  };
 
-  for(char c: lhs){
-    // check for curly braces:
-    switch(c){
-    case '{':
-      n_curly_open++;
-      break;
-    case '}':
-      n_curly_open--;
-      if(n_curly_open < 0){
-        Rcpp::stop("Error parsing the syntax: Found a closing curly brace } without an opening curly brance {. The last line was "  +
-          lhs);
-      }
-      break;
-    }
+  std::size_t unmatched = for_each_top_level(lhs, byte_set(not_allowed), disallowed_found);
 
-    if((n_curly_open != 0) | (c == '}'))
-      continue;
-
-    if(char_in_string(c, not_allowed))
-      Rcpp::stop("The following is not allowed: " +
-        lhs +
-        ". It contains one of the following characters: " +
-        not_allowed);
-  }
+  if(unmatched != std::string_view::npos)
+    parse_stop("Error parsing the syntax: Found a closing curly brace } without an opening curly brance {. The last line was "  +
+      std::string(lhs));
 }
@@ -0,0 +1,549 @@
+#include <Rcpp.h>
+#include <algorithm>
+#include <unordered_set>
+#include "add_elements.h"
+#include "clean_syntax.h"
+#include "check_syntax.h"
+#include "create_algebras.h"
+#include "diagnostics.h"
+#include "groups.h"
+#include "make_parameter_table.h"
+#include "model_blocks.h"
+#include "modules.h"
+#include "scan.h"
+#include "string_operations.h"
+
+// mxsem_check validates a syntax without building a model. In contrast to the
+// parser, which stops at the first error, all equations are checked and each
+// issue is reported with its position in the syntax.
+
+enum class issue_type{error, warning, message};
+
+struct syntax_issue{
+  std::size_t syntax;   // index of the syntax
+  std::size_t model;    // index of the model block in the syntax
+  issue_type type;
+  std::size_t position; // byte offset in the syntax; npos if unknown
+  std::string text;
+};
+
+struct check_settings{
+  bool add_intercept;
+  bool add_variance;
+  bool add_exogenous_latent_covariances;
+  bool add_exogenous_manifest_covariances;
+  bool scale_latent_variance;
+  bool scale_loading;
+};
+
+// a bound (e.g., a > 0) or an equality (e.g., a == b) refers to a label that
+// is only known once all equations were checked
+struct bound_reference{
+  std::string_view label;
+  std::size_t position;
+};
+
+class syntax_checker{
+public:
+  syntax_checker(std::size_t syntax,
+                 std::size_t model,
+                 std::vector<syntax_issue>& issues):
+    syntax(syntax), model(model), issues(issues){}
+
+  void report(issue_type type, std::size_t position, const std::string& text){
+    if(type == issue_type::error)
+      has_error = true;
+    reported.insert(text);
+    issues.push_back({syntax, model, type, position, text});
+  }
+
+  // skips issues that were already reported for this model (e.g., by the
+  // groups of a multi-group model)
+  void report_once(issue_type type, std::size_t position, const std::string& text){
+    if(reported.count(text) == 0)
+      report(type, position, text);
+  }
+
+  // checks one block of a model (a group or the entire model) that starts at
+  // offset in the syntax.
+  void check_block(std::string_view block, std::size_t offset);
+
+  bool found_error() const{
+    return(has_error);
+  }
+
+private:
+  void check_equation_at(std::string_view equation, const source_map& map, std::size_t offset);
+  void check_paths(std::string_view equation, std::string_view op,
+                   const source_map& map, std::size_t offset);
+
+  std::size_t syntax;
+  std::size_t model;
+  std::vector<syntax_issue>& issues;
+  bool has_error = false;
+  std::unordered_set<std::string> reported;
+
+  std::unordered_set<std::string_view> labels;
+  std::vector<bound_reference> bounds;
+  // new parameters (!a) and algebras (a := ...) can be set equal to labels
+  std::unordered_set<std::string_view> algebra_names;
+  std::vector<bound_reference> equalities;
+  // included modules; labels may refer to their parameter tables
+  std::vector<std::shared_ptr<const parsed_module>> modules;
+};
+
+void syntax_checker::check_paths(std::string_view equation,
+                                 std::string_view op,
+                                 const source_map& map,
+                                 std::size_t offset){
+  auto at = [&](std::size_t cleaned_position) -> std::size_t {
+    return(offset + source_position(map, cleaned_position));
+  };
+
+  const std::size_t unsupported = find_unsupported_char(equation);
+  if(unsupported != std::string_view::npos){
+    if(equation[unsupported] == '}'){
+      report(issue_type::error, at(unsupported),
+             "Found a closing curly brace } without an opening curly brance {: " + std::string(equation));
+    }else{
+      report(issue_type::error, at(unsupported),
+             "The following equation contains the unsupported symbol " +
+               std::string(1, equation[unsupported]) + ": " + std::string(equation) + ".");
+    }
+    return;
+  }
+
+  const equation_elements eq_elem = split_string_once(equation, op);
+  const std::size_t lhs_invalid = find_invalid_name_char(eq_elem.lhs);
+  if(eq_elem.lhs.empty() || (lhs_invalid != std::string_view::npos)){
+    report(issue_type::error, at(eq_elem.lhs.empty() ? 0 : lhs_invalid),
+           "The following left hand side does not match the allowed pattern of letters digits and underscores: " +
+             std::string(eq_elem.lhs) + " (in " + std::string(equation) + ").");
+    return;
+  }
+
+  std::pmr::monotonic_buffer_resource arena(256);
+  std::pmr::vector<str_rhs_elem> rhs_elems(&arena);
+  try{
+    rhs_elems = split_eqation_rhs(eq_elem.rhs, &arena);
+  }catch(const parse_error& e){
+    report(issue_type::error, at(eq_elem.rhs.data() - equation.data()), e.what());
+    return;
+  }
+
+  for(const str_rhs_elem& rhs_elem: rhs_elems){
+    const std::size_t rhs_start = rhs_elem.rhs.data() - equation.data();
+    const std::size_t rhs_invalid = find_invalid_name_char(rhs_elem.rhs);
+    if(rhs_elem.rhs.empty() || (rhs_invalid != std::string_view::npos)){
+      report(issue_type::error, at(rhs_elem.rhs.empty() ? rhs_start : rhs_start + rhs_invalid),
+             "The following right hand side does not match the allowed pattern of letters digits and underscores: " +
+               std::string(rhs_elem.rhs) + " (in " + std::string(equation) + ").");
+      continue;
+    }
+
+    if(rhs_elem.modifier.empty() || (rhs_elem.modifier[0] == '{'))
+      continue;
+
+    const std::size_t modifier_start = rhs_elem.modifier.data() - equation.data();
+    if(is_group_modifier(rhs_elem.modifier)){
+      for(std::string_view element: group_modifier_elements(rhs_elem.modifier, &arena)){
+        const std::size_t element_start = element.data() - equation.data();
+        if(element.empty()){
+          report(issue_type::error, at(element_start),
+                 "Found an empty element in the group specific modifier " + std::string(rhs_elem.modifier) + ".");
+        }else if(element.compare("NA") != 0){
+          if(!is_valid_modifier(element))
+            report(issue_type::error, at(element_start),
+                   "The following modifier is not allowed: " + std::string(element));
+          labels.insert(element);
+        }
+      }
+    }else{
+      if(!is_valid_modifier(rhs_elem.modifier))
+        report(issue_type::error, at(modifier_start),
+               "The following modifier is not allowed: " + std::string(rhs_elem.modifier));
+      labels.insert(rhs_elem.modifier);
+    }
+  }
+}
+
+void syntax_checker::check_equation_at(std::string_view equation,
+                                       const source_map& map,
+                                       std::size_t offset){
+  auto at = [&](std::size_t cleaned_position) -> std::size_t {
+    return(offset + source_position(map, cleaned_position));
+  };
+
+  // user defined elements are passed on unchanged
+  if(equation[0] == '{'){
+    if(equation.back() != '}')
+      report(issue_type::error, at(equation.size() - 1),
+             "The following syntax is not allowed: " + std::string(equation) +
+               ". Elements in curly braces must end with }.");
+    return;
+  }
+
+  if(!(is_char_class(equation[0], cc_letter) || (equation[0] == '_') || (equation[0] == '!') ||
+       ((equation[0] == '*') && is_pattern_bound(equation)))){
+    report(issue_type::error, at(0),
+           "The following syntax is not allowed: " + std::string(equation) +
+             ". Each line must start with the name of a variable (e.g., y1) or parameter (e.g., a > .4)");
+    return;
+  }
+
+  if(equation[0] == '!'){
+    std::string_view new_parameter = equation.substr(1);
+    std::size_t disallowed = std::string_view::npos;
+    for_each_top_level(new_parameter, byte_set("!+*=~: "), [&](std::size_t i){
+      disallowed = i;
+      return(false);
+    });
+    if(disallowed != std::string_view::npos)
+      report(issue_type::error, at(disallowed + 1),
+             "The following is not allowed: " + std::string(new_parameter) +
+               ". It contains one of the following characters: !+*=~: ");
+    algebra_names.insert(new_parameter);
+    return;
+  }
+
+  bool has_effect = false;
+
+  static constexpr std::string_view path_operators[] = {"=~", "~~", "~"};
+  for(std::string_view op: path_operators){
+    if(equation.find(op) != std::string_view::npos){
+      has_effect = true;
+      check_paths(equation, op, map, offset);
+      break;
+    }
+  }
+
+  static constexpr std::string_view bound_operators[] = {">", "<"};
+  for(std::string_view op: bound_operators){
+    if(equation.find(op) == std::string_view::npos)
+      continue;
+    has_effect = true;
+    const equation_elements eq_elem = split_string_once(equation, op);
+    bounds.push_back({eq_elem.lhs, at(0)});
+    if(!is_valid_bound(eq_elem.rhs))
+      report(issue_type::error, at(eq_elem.rhs.data() - equation.data()),
+             "Invalid bound " + std::string(eq_elem.rhs) + " in " + std::string(equation) + ".");
+  }
+
+  if(equation.find(":=") != std::string_view::npos){
+    has_effect = true;
+    try{
+      if(!is_in_curly(":=", equation)){
+        const std::string_view lhs = split_string_once(equation, ":=").lhs;
+        check_lhs(lhs);
+        algebra_names.insert(lhs);
+      }
+    }catch(const parse_error& e){
+      report(issue_type::error, at(0), e.what());
+    }
+  }
+
+  if(is_equality(equation)){
+    has_effect = true;
+    try{
+      for(std::string_view element: split_equality(equation)){
+        if(!is_number(element) && (element.rfind("data.", 0) != 0))
+          equalities.push_back({element, at(element.data() - equation.data())});
+      }
+    }catch(const parse_error& e){
+      report(issue_type::error, at(0), e.what());
+    }
+  }
+
+  if(!has_effect)
+    report(issue_type::warning, at(0),
+           "The following line has no effect and is ignored: " + std::string(equation));
+}
+
+void syntax_checker::check_block(std::string_view block, std::size_t offset){
+  labels.clear();
+  bounds.clear();
+  algebra_names.clear();
+  equalities.clear();
+  modules.clear();
+
+  // include lines are replaced with white space so that the positions of all
+  // other equations do not change. The labels of the modules can be used in
+  // bounds of the block.
+  std::string block_without_includes(block);
+  {
+    parse_diagnostics diagnostics;
+    collect_diagnostics collect(diagnostics);
+    try{
+      for(const model_block& include: find_include_lines(block)){
+        std::fill(block_without_includes.begin() + include.header_start,
+                  block_without_includes.begin() + include.syntax_start,
+                  ' ');
+        try{
+          modules.push_back(find_module(include.name));
+        }catch(const parse_error& e){
+          report(issue_type::error, offset + include.header_start, e.what());
+          continue;
+        }
+        // the parsed modules are shared between threads and must not be changed
+        std::pmr::monotonic_buffer_resource elements_arena(256);
+        for(const pt_string& modifier: modules.back()->pt.modifier){
+          if(modifier.empty() || (modifier[0] == '{'))
+            continue;
+          if(is_group_modifier(modifier)){
+            for(std::string_view element: group_modifier_elements(modifier, &elements_arena))
+              labels.insert(element);
+          }else{
+            labels.insert(modifier);
+          }
+        }
+      }
+    }catch(const parse_error& e){
+      report(issue_type::error, std::string_view::npos, e.what());
+      return;
+    }
+  }
+  block = block_without_includes;
+
+  std::pmr::monotonic_buffer_resource arena(2 * block.size() + 256);
+  std::vector<source_map> maps;
+  pt_column equations(&arena);
+  {
+    parse_diagnostics diagnostics;
+    collect_diagnostics collect(diagnostics);
+    try{
+      equations = clean_syntax(block, &arena, &maps);
+    }catch(const parse_error& e){
+      report(issue_type::error, std::string_view::npos, e.what());
+      return;
+    }
+  }
+
+  for(std::size_t i = 0; i < equations.size(); i++){
+    // parse_warning is called by some of the checks (e.g., for NA modifiers)
+    parse_diagnostics diagnostics;
+    {
+      collect_diagnostics collect(diagnostics);
+      try{
+        check_equation_at(equations.at(i), maps.at(i), offset);
+      }catch(const parse_error& e){
+        report(issue_type::error, offset + source_position(maps.at(i), 0), e.what());
+      }
+    }
+    for(const diagnostic& d: diagnostics)
+      report(d.type == diagnostic_type::warning ? issue_type::warning : issue_type::message,
+             offset + source_position(maps.at(i), 0), d.text);
+  }
+
+  for(const bound_reference& bound: bounds){
+    if(is_bound_category(bound.label)){
+      // categories (e.g., variances(manifest)) may only match elements that
+      // are added automatically, so only the syntax is checked
+      parse_diagnostics diagnostics;
+      collect_diagnostics collect(diagnostics);
+      try{
+        parse_bound_category(bound.label);
+      }catch(const parse_error& e){
+        report(issue_type::error, bound.position, e.what());
+      }
+    }else if(is_bound_pattern(bound.label)){
+      if(std::none_of(labels.begin(), labels.end(), [&](std::string_view label){
+        return(matches_pattern(bound.label, label));
+      })){
+        if(is_ambiguous_pattern(bound.label))
+          report(issue_type::error, bound.position,
+                 "Found a constraint on the following parameter: " + std::string(bound.label) +
+                   ", but could not find this parameter in your model. Patterns with * between two " +
+                   "characters (e.g., b*c) must match at least one label.");
+        else
+          report(issue_type::warning, bound.position,
+                 "The bound on " + std::string(bound.label) + " does not match the label of any parameter.");
+      }
+    }else if(labels.count(bound.label) == 0){
+      report(issue_type::error, bound.position,
+             "Found a constraint on the following parameter: " + std::string(bound.label) +
+               ", but could not find this parameter in your model.");
+    }
+  }
+
+  for(const bound_reference& equality: equalities){
+    if((labels.count(equality.label) == 0) && (algebra_names.count(equality.label) == 0))
+      report(issue_type::error, equality.position,
+             "Found an equality constraint on the following parameter: " + std::string(equality.label) +
+               ", but could not find this parameter in your model.");
+  }
+}
+
+// runs the parser on a model that passed all checks. The remaining issues
+// (e.g., warnings when scaling latent variables) have no position.
+static void parse_model(std::string_view model_syntax,
+                        const check_settings& settings,
+                        syntax_checker& checker){
+  parse_diagnostics diagnostics;
+  {
+    collect_diagnostics collect(diagnostics);
+    try{
+      std::pmr::monotonic_buffer_resource arena(4 * model_syntax.size() + 1024);
+      const std::vector<model_block> blocks = find_group_blocks(model_syntax);
+      const bool has_group_blocks = !blocks.front().name.empty();
+      for(std::size_t b = 0; b < blocks.size(); b++){
+        parameter_table shared(&arena);
+        const pt_column equations = parse_equations(
+          model_syntax.substr(blocks.at(b).syntax_start,
+                              blocks.at(b).syntax_end - blocks.at(b).syntax_start),
+                              shared);
+        const std::size_t n_groups = has_group_blocks ? blocks.size() : count_groups(shared);
+        const std::size_t first = has_group_blocks ? b : 0;
+        const std::size_t last = has_group_blocks ? b + 1 : n_groups;
+        for(std::size_t g = first; g < last; g++){
+          parameter_table pt(&arena);
+          pt.lhs = shared.lhs;
+          pt.op = shared.op;
+          pt.rhs = shared.rhs;
+          pt.modifier = shared.modifier;
+          pt.lbound = shared.lbound;
+          pt.ubound = shared.ubound;
+          pt.free = shared.free;
+          pt.user_defined = shared.user_defined;
+          complete_parameter_table(equations, pt, g, n_groups,
+                                   settings.add_intercept,
+                                   settings.add_variance,
+                                   settings.add_exogenous_latent_covariances,
+                                   settings.add_exogenous_manifest_covariances,
+                                   settings.scale_latent_variance,
+                                   settings.scale_loading);
+        }
+      }
+    }catch(const parse_error& e){
+      checker.report(issue_type::error, std::string_view::npos, e.what());
+    }
+  }
+  for(const diagnostic& d: diagnostics)
+    checker.report_once(d.type == diagnostic_type::warning ? issue_type::warning : issue_type::message,
+                        std::string_view::npos, d.text);
+}
+
+static std::vector<syntax_issue> check_syntax(std::string_view syntax,
+                                              std::size_t syntax_index,
+                                              const check_settings& settings,
+                                              std::vector<std::string>& model_names){
+  std::vector<syntax_issue> issues;
+
+  const std::vector<model_block> models = find_model_blocks(syntax);
+  for(std::size_t m = 0; m < models.size(); m++){
+    model_names.push_back(models.at(m).name);
+    syntax_checker checker(syntax_index, model_names.size() - 1, issues);
+
+    const std::string_view model_syntax = syntax.substr(models.at(m).syntax_start,
+                                                        models.at(m).syntax_end - models.at(m).syntax_start);
+
+    std::vector<model_block> groups;
+    {
+      parse_diagnostics diagnostics;
+      collect_diagnostics collect(diagnostics);
+      try{
+        groups = find_group_blocks(model_syntax);
+      }catch(const parse_error& e){
+        checker.report(issue_type::error, models.at(m).syntax_start, e.what());
+        continue;
+      }
+    }
+
+    for(const model_block& group: groups)
+      checker.check_block(model_syntax.substr(group.syntax_start, group.syntax_end - group.syntax_start),
+                          models.at(m).syntax_start + group.syntax_start);
+
+    if(!checker.found_error())
+      parse_model(model_syntax, settings, checker);
+  }
+
+  return(issues);
+}
+
+//' check_syntax_rcpp
+//'
+//' checks model syntaxes without building the models. All equations are checked
+//' and each issue is reported with its position in the syntax.
+//' @param syntaxes vector with lavaan like syntaxes
+//' @param add_intercept should intercepts for manifest variables be automatically added?
+//' @param add_variance should variances for all variables be automatically added?
+//' @param add_exogenous_latent_covariances should covariances between exogenous latent variables be
+//' added automatically?
+//' @param add_exogenous_manifest_covariances should covariances between exogenous manifest variables be
+//' added automatically?
+//' @param scale_latent_variance should variances of latent variables be set to 1?
+//' @param scale_loading should the first loading of each latent variable be set to 1?
+//' @return data.frame with one row per issue: the index of the syntax (syntax), the name of
+//' the model (model), the type of the issue (error, warning, or message), the line and column
+//' of the issue (NA if the issue does not refer to a specific line), and the message.
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::DataFrame check_syntax_rcpp(const std::vector<std::string>& syntaxes,
+                                  bool add_intercept,
+                                  bool add_variance,
+                                  bool add_exogenous_latent_covariances,
+                                  bool add_exogenous_manifest_covariances,
+                                  bool scale_latent_variance,
+                                  bool scale_loading){
+
+  const check_settings settings{add_intercept,
+                                add_variance,
+                                add_exogenous_latent_covariances,
+                                add_exogenous_manifest_covariances,
+                                scale_latent_variance,
+                                scale_loading};
+
+  std::vector<int> syntax_column, line_column, column_column;
+  std::vector<std::string> model_column, type_column, message_column;
+  std::vector<std::string> model_names;
+
+  for(std::size_t s = 0; s < syntaxes.size(); s++){
+    const std::string& syntax = syntaxes.at(s);
+    std::vector<syntax_issue> issues = check_syntax(syntax, s, settings, model_names);
+
+    // issues without a position are listed after all issues of their model
+    std::stable_sort(issues.begin(), issues.end(),
+                     [](const syntax_issue& a, const syntax_issue& b){
+                       if(a.model != b.model)
+                         return(a.model < b.model);
+                       return(a.position < b.position);
+                     });
+
+    std::vector<std::size_t> line_starts{0};
+    for(std::size_t i = syntax.find('\n'); i != std::string::npos; i = syntax.find('\n', i + 1))
+      line_starts.push_back(i + 1);
+
+    for(const syntax_issue& issue: issues){
+      syntax_column.push_back(static_cast<int>(issue.syntax + 1));
+      model_column.push_back(model_names.at(issue.model));
+      switch(issue.type){
+      case issue_type::error:
+        type_column.push_back("error");
+        break;
+      case issue_type::warning:
+        type_column.push_back("warning");
+        break;
+      case issue_type::message:
+        type_column.push_back("message");
+        break;
+      }
+      if(issue.position == std::string_view::npos){
+        line_column.push_back(NA_INTEGER);
+        column_column.push_back(NA_INTEGER);
+      }else{
+        const std::size_t line = std::upper_bound(line_starts.begin(), line_starts.end(), issue.position) -
+          line_starts.begin();
+        line_column.push_back(static_cast<int>(line));
+        column_column.push_back(static_cast<int>(issue.position - line_starts.at(line - 1) + 1));
+      }
+      message_column.push_back(issue.text);
+    }
+  }
+
+  return(Rcpp::DataFrame::create(Rcpp::Named("syntax") = syntax_column,
+                                 Rcpp::Named("model") = model_column,
+                                 Rcpp::Named("type") = type_column,
+                                 Rcpp::Named("line") = line_column,
+                                 Rcpp::Named("column") = column_column,
+                                 Rcpp::Named("message") = message_column,
+                                 Rcpp::Named("stringsAsFactors") = false));
+}
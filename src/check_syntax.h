@@ -1,9 +1,27 @@
 #ifndef CHECK_SYNTAX_H
 #define CHECK_SYNTAX_H
 #include "parameter_table.h"
+#include <string_view>
 
-void check_modifier(const std::string modifier);
+void check_modifier(std::string_view modifier);
 
-void check_equation(const std::string equation);
+// returns the position of the first character of equation that is not allowed
+// outside of curly braces or of a closing curly brace without an opening brace.
+// Returns std::string_view::npos if the equation is valid.
+std::size_t find_unsupported_char(std::string_view equation);
+
+void check_equation(std::string_view equation);
+
+// rules for the fields of the parameter table, shared by the parser,
+// mxsem_check, and check_all_fields in R.
+// position of the first character of a variable name that is not a letter,
+// digit, or underscore; std::string_view::npos if the name is valid
+std::size_t find_invalid_name_char(std::string_view name);
+// a modifier is either a value or a label (definition variables are labels
+// starting with data.)
+bool is_valid_modifier(std::string_view modifier);
+bool is_valid_bound(std::string_view bound);
+// throws for the first invalid variable, modifier, or bound of the table
+void check_fields(const parameter_table& pt);
 
 #endif
@@ -1,6 +1,9 @@
 #include <Rcpp.h>
+#include <algorithm>
 #include "string_operations.h"
 #include "clean_syntax.h"
+#include "diagnostics.h"
+#include "scan.h"
 
 //' clean_syntax
 //'
@@ -9,14 +12,85 @@
 //' @return vector of strings with cleaned syntax
 // [[Rcpp::export]]
 std::vector<std::string> clean_syntax(const std::string& syntax) {
-  std::vector<std::string> cleaned_syntax;
-  std::string current_syntax {""};
+  pt_column cleaned_syntax = clean_syntax(std::string_view(syntax), std::pmr::get_default_resource());
+  return(std::vector<std::string>(cleaned_syntax.begin(), cleaned_syntax.end()));
+}
+
+std::size_t source_position(const source_map& map, std::size_t cleaned_position){
+  if(map.empty())
+    return(0);
+  auto run = std::upper_bound(map.begin(), map.end(), cleaned_position,
+                              [](std::size_t position, const source_run& r){
+                                return(position < r.cleaned);
+                              });
+  if(run != map.begin())
+    --run;
+  return(run->original + (cleaned_position - run->cleaned));
+}
+
+pt_column clean_syntax(std::string_view syntax,
+                       std::pmr::memory_resource* mr,
+                       std::vector<source_map>* source_maps) {
+  pt_column cleaned_syntax(mr);
+  // current_syntax is cleared, but not freed, after each equation so that
+  // its buffer can be reused for the next one.
+  pt_string current_syntax(mr);
+  source_map current_map;
+
+  // records where the next characters added to current_syntax come from
+  auto record_source = [&](std::size_t original){
+    if(source_maps == nullptr)
+      return;
+    if(!current_map.empty() &&
+       (current_map.back().original + (current_syntax.size() - current_map.back().cleaned) == original))
+      return;
+    current_map.push_back({current_syntax.size(), original});
+  };
+  auto add_equation = [&](){
+    cleaned_syntax.emplace_back(current_syntax);
+    current_syntax.clear();
+    if(source_maps != nullptr){
+      source_maps->push_back(std::move(current_map));
+      current_map.clear();
+    }
+  };
   bool is_comment  = false;
   bool is_open     = false;
   int n_curly_open = 0; // indicates if the user specified a block of code
   // that should not be changed
 
-  for(char c: syntax){
+  // Depending on the state, only some characters need special treatment. We
+  // jump from one of these characters to the next; everything in between is
+  // copied (or skipped in comments) at once.
+  static const byte_set special_in_curly("{}");
+  static const byte_set special_in_comment("\n");
+  static const byte_set special_in_syntax("{} \t#\n;+*=~:");
+
+  std::size_t position = 0;
+  while(position < syntax.size()){
+
+    const byte_set& special = (n_curly_open != 0) ? special_in_curly :
+      (is_comment ? special_in_comment : special_in_syntax);
+    const std::size_t next_special = special.find(syntax, position);
+
+    if(next_special > position){
+      std::string_view plain = syntax.substr(position, next_special - position);
+      if(n_curly_open != 0){
+        record_source(position);
+        current_syntax += plain;
+      }else if(!is_comment){
+        // none of the plain characters is an operator
+        is_open = false;
+        record_source(position);
+        current_syntax += plain;
+      }
+      position = next_special;
+      if(position == syntax.size())
+        break;
+    }
+
+    const char c = syntax[position];
+    position++;
 
     // check for curly braces:
     switch(c){
@@ -30,12 +104,13 @@ std::vector<std::string> clean_syntax(const std::string& syntax) {
         break;
       n_curly_open--;
       if(n_curly_open < 0){
-        Rcpp::stop("Error parsing the syntax: Found a closing curly brace } without an opening curly brance {. The last line was "  +
-          current_syntax);
+        parse_stop("Error parsing the syntax: Found a closing curly brace } without an opening curly brance {. The last line was "  +
+          std::string(current_syntax));
       }
       break;
     }
     if(n_curly_open != 0){
+      record_source(position - 1);
       current_syntax += c;
       continue;
     }
@@ -58,8 +133,7 @@ std::vector<std::string> clean_syntax(const std::string& syntax) {
       is_comment = false;
       if(!is_open && (current_syntax.length() != 0)){
         // add current syntax if the string did end and is not empty
-        cleaned_syntax.push_back(current_syntax);
-        current_syntax = "";
+        add_equation();
         break;
       }
       break;
@@ -70,34 +144,34 @@ std::vector<std::string> clean_syntax(const std::string& syntax) {
       // the only difference to a new line is that commands cannot continue after
       // a semicolon.
       if(is_open)
-        Rcpp::stop("Line ended with ; but it seems like the previous sign was an operator (e.g., =~;!). The last line was " +
-          current_syntax);
+        parse_stop("Line ended with ; but it seems like the previous sign was an operator (e.g., =~;!). The last line was " +
+          std::string(current_syntax));
       if(current_syntax.length() != 0){
-        cleaned_syntax.push_back(current_syntax);
-        current_syntax = "";
+        add_equation();
         break;
       }
       break;
     default:
         if(is_comment)
           break;
-        if(char_in_string(c, "+*=~:")){
+        if(is_char_class(c, cc_operator)){
           // is_open allows for line breaks.
           is_open = true;
         }else{
           is_open = false;
         }
+        record_source(position - 1);
         current_syntax += c;
         break;
     }
   }
 
   if(n_curly_open != 0)
-    Rcpp::stop("Found unbalanced curly braces (e.g., {{}) in your syntax.");
+    parse_stop("Found unbalanced curly braces (e.g., {{}) in your syntax.");
 
   // if the syntax does not end with a new line -> add last element:
   if(current_syntax.length() != 0)
-    cleaned_syntax.push_back(current_syntax);
+    add_equation();
 
   return(cleaned_syntax);
 }
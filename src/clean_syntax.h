@@ -1,9 +1,30 @@
 #ifndef CLEAN_SYNTAX_H
 #define CLEAN_SYNTAX_H
 #include <Rcpp.h>
+#include "parameter_table.h"
+#include <string_view>
+
+// Maps the characters of a cleaned equation back to the syntax. Each run
+// starts at the position cleaned in the equation and at the position original
+// in the syntax; the characters of a run are contiguous in both.
+struct source_run{
+  std::size_t cleaned;
+  std::size_t original;
+};
+
+typedef std::vector<source_run> source_map;
+
+// position in the syntax of the character at cleaned_position in the equation
+std::size_t source_position(const source_map& map, std::size_t cleaned_position);
 
 std::vector<std::string> clean_syntax(const std::string& syntax);
 
-void check_cleaned(const std::vector<std::string> cleaned_syntax);
+// If source_maps is not a null pointer, one source_map per cleaned equation
+// is added to source_maps.
+pt_column clean_syntax(std::string_view syntax,
+                       std::pmr::memory_resource* mr,
+                       std::vector<source_map>* source_maps = nullptr);
+
+void check_cleaned(const pt_column& cleaned_syntax);
 
 #endif
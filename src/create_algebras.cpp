@@ -2,16 +2,22 @@
 #include "string_operations.h"
 #include "clean_syntax.h"
 #include "create_algebras.h"
+#include "diagnostics.h"
+#include "scan.h"
 
-bool is_in_curly(const std::string& what, const std::string& where){
+bool is_in_curly(std::string_view what, std::string_view where){
   int n_curly = 0;
   unsigned int match   = 0;
-  for(char c: where){
+  // only the braces and the characters of what are relevant
+  byte_set relevant(what);
+  relevant.add("{}");
+  for(std::size_t i = relevant.find(where); i < where.size(); i = relevant.find(where, i + 1)){
+    const char c = where[i];
     if(c == '{')
       n_curly++;
     if(c == '}'){
       if(n_curly == 0)
-        Rcpp::stop("Unmatched closing bracket in " + where);
+        parse_stop("Unmatched closing bracket in " + std::string(where));
       n_curly--;
       }
     if(c == what[match]){
@@ -24,41 +30,43 @@ bool is_in_curly(const std::string& what, const std::string& where){
     }
   }
 
-  Rcpp::stop("No match found");
+  parse_stop("No match found");
 
 }
 
-void make_algebras(const std::vector<std::string>& equations,
+void make_algebras(const pt_column& equations,
                    parameter_table& pt){
 
-  algebra alg;
+  algebra alg(pt.resource());
 
   // find newly created variables
-  for(std::string eq: equations){
+  for(const pt_string& eq: equations){
     if(eq.at(0) == '{'){
       // skip user defined
       continue;
     }
     if(eq.at(0) == '!'){
       // remove exclamation mark
-      eq.erase(eq.begin());
+      std::string_view new_parameter = eq;
+      new_parameter.remove_prefix(1);
       // check_lhs can be used to check for disallowed elements:
-      check_lhs(eq, "!+*=~: ");
-      alg.new_parameters.push_back(eq);
-      alg.new_parameters_free.push_back("TRUE");
+      check_lhs(new_parameter, "!+*=~: ");
+      alg.new_parameters.emplace_back(new_parameter);
+      alg.new_parameters_free.emplace_back("TRUE");
     }
   }
 
   equation_elements eq_elem;
 
-  for(std::string eq: equations){
+  static constexpr std::string_view check_for[] = {":="};
+
+  for(const pt_string& eq: equations){
     if(eq.at(0) == '{'){
       // skip user defined
       continue;
     }
-    std::vector<std::string> check_for = {":="};
 
-    for(std::string c_for: check_for){
+    for(std::string_view c_for: check_for){
 
       if(eq.find(c_for) != std::string::npos){
 
@@ -71,9 +79,9 @@ void make_algebras(const std::vector<std::string>& equations,
 
         check_lhs(eq_elem.lhs);
 
-        alg.lhs.push_back(eq_elem.lhs);
-        alg.op.push_back(c_for);
-        alg.rhs.push_back(eq_elem.rhs);
+        alg.lhs.emplace_back(eq_elem.lhs);
+        alg.op.emplace_back(c_for);
+        alg.rhs.emplace_back(eq_elem.rhs);
 
         // If an element is on the left hand side of an equation, it is no longer free:
         for(unsigned int i = 0; i < pt.modifier.size(); i++){
@@ -92,5 +100,5 @@ void make_algebras(const std::vector<std::string>& equations,
     }
   }
 
-  pt.alg = alg;
+  pt.alg = std::move(alg);
 }
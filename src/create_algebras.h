@@ -2,8 +2,12 @@
 #define CREATE_ALGEBRAS_H
 #include "parameter_table.h"
 #include <Rcpp.h>
+#include <string_view>
 
-void make_algebras(const std::vector<std::string>& equations,
+// checks if what is inside of curly braces in where
+bool is_in_curly(std::string_view what, std::string_view where);
+
+void make_algebras(const pt_column& equations,
                    parameter_table& pt);
 
 #endif
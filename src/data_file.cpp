@@ -0,0 +1,410 @@
+#include <Rcpp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+#include "r_conversion.h"
+
+// Data files are read in blocks of rows. Only the columns that are used by
+// the model are extracted, so the memory needed does not depend on the number
+// of columns in the file. If only the moments are needed, no row is kept after
+// its block was processed.
+//
+// Binary format of a data file (all integers in the byte order of the machine
+// that wrote the file):
+//
+// header:  char[8] "MXSEMDT", uint32 version, uint32 byte order mark
+// columns: uint32 n, then n times uint32 length and the characters of the name
+// rows:    uint64 n
+// values:  the n rows of the first column as double, followed by the rows of
+//          the second column, etc. Missing values are NaN.
+//
+// Because the values are stored column by column, the columns of the model are
+// read without reading the other columns.
+static constexpr char data_file_magic[8] = {'M', 'X', 'S', 'E', 'M', 'D', 'T', '\0'};
+static const std::uint32_t data_file_version = 1;
+static const std::uint32_t byte_order_mark = 0x01020304;
+static constexpr std::size_t rows_per_block = 4096;
+
+// values of the selected columns for one block of rows: block[column][row]
+typedef std::vector<std::vector<double>> data_block;
+typedef std::function<void(const data_block& block, std::size_t n_rows)> block_callback;
+
+static bool is_data_file(const std::string& file){
+  std::ifstream stream(file, std::ios::binary);
+  if(!stream)
+    Rcpp::stop("Could not open " + file + ".");
+  char magic[sizeof(data_file_magic)] = {};
+  stream.read(magic, sizeof(magic));
+  return((stream.gcount() == sizeof(magic)) &&
+         (std::memcmp(magic, data_file_magic, sizeof(magic)) == 0));
+}
+
+// maps each selected column to its position in names
+static std::vector<std::size_t> find_columns(const std::vector<std::string>& names,
+                                             const std::vector<std::string>& columns,
+                                             const std::string& file){
+  std::unordered_map<std::string_view, std::size_t> positions;
+  for(std::size_t i = 0; i < names.size(); i++)
+    positions.emplace(names.at(i), i);
+  std::vector<std::size_t> selected;
+  for(const std::string& column: columns){
+    auto position = positions.find(column);
+    if(position == positions.end())
+      Rcpp::stop("Could not find the variable " + column + " in " + file + ".");
+    selected.push_back(position->second);
+  }
+  return(selected);
+}
+
+static void read_binary_file(const std::string& file,
+                             const std::vector<std::string>& columns,
+                             const block_callback& callback){
+  std::ifstream stream(file, std::ios::binary);
+  auto read = [&](char* to, std::size_t n){
+    stream.read(to, static_cast<std::streamsize>(n));
+    if(static_cast<std::size_t>(stream.gcount()) != n)
+      Rcpp::stop("The data file " + file + " is truncated or corrupted.");
+  };
+  auto read_uint32 = [&](){
+    std::uint32_t value;
+    read(reinterpret_cast<char*>(&value), sizeof(value));
+    return(value);
+  };
+
+  char magic[sizeof(data_file_magic)];
+  read(magic, sizeof(magic));
+  const std::uint32_t version = read_uint32();
+  if(version != data_file_version)
+    Rcpp::stop("The data file was created with a different version of mxsem (file format " +
+      std::to_string(version) + ").");
+  if(read_uint32() != byte_order_mark)
+    Rcpp::stop("The data file was created on a machine with a different byte order.");
+
+  std::vector<std::string> names(read_uint32());
+  for(std::string& name: names){
+    name.resize(read_uint32());
+    read(name.data(), name.size());
+  }
+  std::uint64_t n_rows;
+  read(reinterpret_cast<char*>(&n_rows), sizeof(n_rows));
+  const std::streamoff values_start = stream.tellg();
+
+  const std::vector<std::size_t> selected = find_columns(names, columns, file);
+  data_block block(selected.size());
+  for(std::uint64_t first = 0; first < n_rows; first += rows_per_block){
+    const std::size_t n_block = static_cast<std::size_t>(std::min<std::uint64_t>(rows_per_block, n_rows - first));
+    for(std::size_t c = 0; c < selected.size(); c++){
+      block[c].resize(n_block);
+      stream.seekg(values_start +
+        static_cast<std::streamoff>((selected[c] * n_rows + first) * sizeof(double)));
+      read(reinterpret_cast<char*>(block[c].data()), n_block * sizeof(double));
+    }
+    callback(block, n_block);
+  }
+}
+
+// calls fn(index, field) for each field of a line of a delimited text file.
+// Quotes around a field are removed and doubled quotes within a quoted field
+// ("") are replaced with a single quote.
+template<class F>
+static void for_each_field(std::string_view line, const char separator, F fn){
+  std::size_t index = 0;
+  std::size_t start = 0;
+  // only used for quoted fields with doubled quotes
+  std::string unescaped;
+  while(true){
+    std::size_t end;
+    std::string_view field;
+    if((start < line.size()) && (line[start] == '"')){
+      std::size_t closing = line.find('"', start + 1);
+      bool has_escapes = false;
+      while((closing != std::string_view::npos) && (closing + 1 < line.size()) && (line[closing + 1] == '"')){
+        has_escapes = true;
+        closing = line.find('"', closing + 2);
+      }
+      if(closing == std::string_view::npos)
+        Rcpp::stop("Found a field with an unbalanced quote: " + std::string(line));
+      field = line.substr(start + 1, closing - start - 1);
+      if(has_escapes){
+        unescaped.clear();
+        for(std::size_t i = 0; i < field.size(); i++){
+          unescaped += field[i];
+          if(field[i] == '"')
+            i++;
+        }
+        field = unescaped;
+      }
+      end = line.find(separator, closing);
+    }else{
+      end = line.find(separator, start);
+      field = line.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+    }
+    if(!fn(index++, field) || (end == std::string_view::npos))
+      return;
+    start = end + 1;
+  }
+}
+
+static double parse_value(std::string_view field, bool& is_valid){
+  is_valid = true;
+  while(!field.empty() && ((field.front() == ' ') || (field.front() == '\t')))
+    field.remove_prefix(1);
+  while(!field.empty() && ((field.back() == ' ') || (field.back() == '\t')))
+    field.remove_suffix(1);
+  if(field.empty() || (field == "NA") || (field == "NaN"))
+    return(NAN);
+  const std::string value(field);
+  char* end;
+  const double number = std::strtod(value.c_str(), &end);
+  is_valid = end == value.c_str() + value.size();
+  return(number);
+}
+
+static void read_text_file(const std::string& file,
+                           const std::vector<std::string>& columns,
+                           const block_callback& callback){
+  std::ifstream stream(file, std::ios::binary);
+  std::string line;
+  if(!std::getline(stream, line))
+    Rcpp::stop(file + " is empty.");
+  if(!line.empty() && (line.back() == '\r'))
+    line.pop_back();
+
+  // the separator is the first comma, tab, or semicolon in the header
+  const std::size_t separator_position = line.find_first_of(",\t;");
+  const char separator = separator_position == std::string::npos ? ',' : line[separator_position];
+
+  std::vector<std::string> names;
+  for_each_field(line, separator, [&](std::size_t, std::string_view field){
+    names.emplace_back(field);
+    return(true);
+  });
+  const std::vector<std::size_t> selected = find_columns(names, columns, file);
+  // the selected column of each field or npos
+  std::vector<std::size_t> column_of_field(names.size(), std::string::npos);
+  std::size_t last_field = 0;
+  for(std::size_t c = 0; c < selected.size(); c++){
+    column_of_field[selected[c]] = c;
+    last_field = std::max(last_field, selected[c]);
+  }
+
+  data_block block(selected.size(), std::vector<double>(rows_per_block));
+  std::size_t n_block = 0;
+  auto next_row = [&](){
+    if(++n_block == rows_per_block){
+      callback(block, n_block);
+      n_block = 0;
+    }
+  };
+
+  // empty lines are only skipped at the end of the file. In a file with a
+  // single column, an empty line is a missing value.
+  std::size_t n_empty = 0;
+  std::size_t line_number = 1;
+  while(std::getline(stream, line)){
+    line_number++;
+    if(!line.empty() && (line.back() == '\r'))
+      line.pop_back();
+    if(line.empty()){
+      n_empty++;
+      continue;
+    }
+    for(; n_empty > 0; n_empty--){
+      if(names.size() != 1)
+        Rcpp::stop("Line " + std::to_string(line_number - n_empty) + " of " + file + " is empty.");
+      block[0][n_block] = NAN;
+      next_row();
+    }
+
+    std::size_t n_fields = 0;
+    for_each_field(line, separator, [&](std::size_t index, std::string_view field){
+      n_fields = index + 1;
+      if((index < column_of_field.size()) && (column_of_field[index] != std::string::npos)){
+        bool is_valid;
+        block[column_of_field[index]][n_block] = parse_value(field, is_valid);
+        if(!is_valid)
+          Rcpp::stop("Could not read the value " + std::string(field) + " of the variable " +
+            names.at(index) + " in line " + std::to_string(line_number) + " of " + file + ".");
+      }
+      // the remaining fields are not needed
+      return(index < last_field);
+    });
+    if(n_fields <= last_field)
+      Rcpp::stop("Line " + std::to_string(line_number) + " of " + file + " has fewer fields than the header.");
+
+    next_row();
+  }
+  if(n_block > 0)
+    callback(block, n_block);
+}
+
+static void read_data_file(const std::string& file,
+                           const std::vector<std::string>& columns,
+                           const block_callback& callback){
+  if(is_data_file(file))
+    read_binary_file(file, columns, callback);
+  else
+    read_text_file(file, columns, callback);
+}
+
+// means and covariances of the rows without missing values, updated one row at
+// a time (Welford's algorithm)
+class moment_accumulator{
+public:
+  explicit moment_accumulator(std::size_t n_columns):
+  means(n_columns, 0.0), co_moments(n_columns * n_columns, 0.0), deltas(n_columns){}
+
+  void add(const data_block& block, std::size_t n_rows){
+    const std::size_t n_columns = means.size();
+    for(std::size_t r = 0; r < n_rows; r++){
+      bool is_complete = true;
+      for(std::size_t c = 0; c < n_columns; c++)
+        is_complete = is_complete && !std::isnan(block[c][r]);
+      if(!is_complete){
+        n_incomplete++;
+        continue;
+      }
+      n_complete++;
+      for(std::size_t c = 0; c < n_columns; c++){
+        deltas[c] = block[c][r] - means[c];
+        means[c] += deltas[c] / static_cast<double>(n_complete);
+      }
+      for(std::size_t c = 0; c < n_columns; c++){
+        for(std::size_t k = c; k < n_columns; k++)
+          co_moments[c * n_columns + k] += deltas[c] * (block[k][r] - means[k]);
+      }
+    }
+  }
+
+  std::vector<double> means;
+  // upper triangle of the sums of cross products of the deviations
+  std::vector<double> co_moments;
+  std::size_t n_complete = 0;
+  std::size_t n_incomplete = 0;
+
+private:
+  std::vector<double> deltas;
+};
+
+//' read_data_file_rcpp
+//'
+//' reads the columns of a data file that are used by a model. The file is either a
+//' delimited text file with a header (separated by commas, tabs, or semicolons; missing
+//' values are empty or NA) or a binary file created with write_data_file_rcpp. The file
+//' is read in blocks of rows, and all other columns are skipped.
+//' @param file path to the file
+//' @param columns names of the columns that are read
+//' @param moments if TRUE, only the means and covariances of the columns are computed
+//' (in one pass over the file, using all rows without missing values) instead of
+//' returning the data
+//' @return if moments is FALSE, a data.frame with the columns. Otherwise, a list with
+//' the covariance matrix (covariance; denominator N-1 as in stats::cov), the means,
+//' the number of rows without missing values (n_observations), and the number of
+//' rows with missing values (n_incomplete).
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::List read_data_file_rcpp(const std::string& file,
+                               const std::vector<std::string>& columns,
+                               bool moments = false){
+  const std::size_t n_columns = columns.size();
+  Rcpp::CharacterVector column_names(n_columns);
+  for(std::size_t c = 0; c < n_columns; c++)
+    column_names[c] = columns[c];
+
+  if(!moments){
+    std::vector<std::vector<double>> values(n_columns);
+    std::size_t n_rows_total = 0;
+    read_data_file(file, columns, [&](const data_block& block, std::size_t n_rows){
+      n_rows_total += n_rows;
+      for(std::size_t c = 0; c < n_columns; c++)
+        values[c].insert(values[c].end(), block[c].begin(), block[c].begin() + n_rows);
+    });
+
+    Rcpp::List data(n_columns);
+    for(std::size_t c = 0; c < n_columns; c++){
+      Rcpp::NumericVector column(values[c].size());
+      for(std::size_t r = 0; r < values[c].size(); r++)
+        column[r] = std::isnan(values[c][r]) ? NA_REAL : values[c][r];
+      data[c] = column;
+      // the data.frame is built column by column to keep the peak memory low
+      std::vector<double>().swap(values[c]);
+    }
+    return(make_data_frame(data, column_names, static_cast<R_xlen_t>(n_rows_total)));
+  }
+
+  moment_accumulator accumulator(n_columns);
+  read_data_file(file, columns, [&](const data_block& block, std::size_t n_rows){
+    accumulator.add(block, n_rows);
+  });
+  if(accumulator.n_complete < 2)
+    Rcpp::stop(file + " has fewer than two rows without missing values.");
+
+  Rcpp::NumericMatrix covariance(n_columns, n_columns);
+  Rcpp::NumericVector means(n_columns);
+  for(std::size_t c = 0; c < n_columns; c++){
+    means[c] = accumulator.means[c];
+    for(std::size_t k = c; k < n_columns; k++){
+      const double value = accumulator.co_moments[c * n_columns + k] /
+        static_cast<double>(accumulator.n_complete - 1);
+      covariance(c, k) = value;
+      covariance(k, c) = value;
+    }
+  }
+  covariance.attr("dimnames") = Rcpp::List::create(column_names, column_names);
+  means.attr("names") = column_names;
+
+  return(Rcpp::List::create(Rcpp::Named("covariance") = covariance,
+                            Rcpp::Named("means") = means,
+                            Rcpp::Named("n_observations") = static_cast<double>(accumulator.n_complete),
+                            Rcpp::Named("n_incomplete") = static_cast<double>(accumulator.n_incomplete)));
+}
+
+//' write_data_file_rcpp
+//'
+//' writes numeric data to a binary data file that can be read with read_data_file_rcpp.
+//' @param data data.frame with numeric columns
+//' @param file path to the file
+//' @return nothing
+//' @keywords internal
+// [[Rcpp::export]]
+void write_data_file_rcpp(Rcpp::List data,
+                          const std::string& file){
+  const std::vector<std::string> names = Rcpp::as<std::vector<std::string>>(data.names());
+
+  std::ofstream stream(file, std::ios::binary | std::ios::trunc);
+  if(!stream)
+    Rcpp::stop("Could not open " + file + " for writing.");
+  auto write = [&](const char* from, std::size_t n){
+    stream.write(from, static_cast<std::streamsize>(n));
+  };
+  auto write_uint32 = [&](std::uint32_t value){
+    write(reinterpret_cast<const char*>(&value), sizeof(value));
+  };
+
+  write(data_file_magic, sizeof(data_file_magic));
+  write_uint32(data_file_version);
+  write_uint32(byte_order_mark);
+  write_uint32(static_cast<std::uint32_t>(names.size()));
+  for(const std::string& name: names){
+    write_uint32(static_cast<std::uint32_t>(name.size()));
+    write(name.data(), name.size());
+  }
+  const std::uint64_t n_rows = names.empty() ? 0 : static_cast<std::uint64_t>(Rf_xlength(VECTOR_ELT(data, 0)));
+  write(reinterpret_cast<const char*>(&n_rows), sizeof(n_rows));
+
+  // one column at a time, so only one column is converted at once
+  for(const std::string& name: names){
+    const std::vector<double> values = read_numeric_column(data, name);
+    if(values.size() != n_rows)
+      Rcpp::stop("All columns of data must have the same length.");
+    write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+  }
+  if(!stream)
+    Rcpp::stop("Could not write to " + file + ".");
+}
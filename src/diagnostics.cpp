@@ -0,0 +1,55 @@
+#include "diagnostics.h"
+
+namespace {
+thread_local parse_diagnostics* current_diagnostics = nullptr;
+}
+
+collect_diagnostics::collect_diagnostics(parse_diagnostics& diagnostics):
+  previous(current_diagnostics){
+  current_diagnostics = &diagnostics;
+}
+
+collect_diagnostics::~collect_diagnostics(){
+  current_diagnostics = previous;
+}
+
+bool collecting_diagnostics(){
+  return(current_diagnostics != nullptr);
+}
+
+void parse_stop(const std::string& text){
+  if(collecting_diagnostics())
+    throw parse_error(text);
+  Rcpp::stop(text);
+}
+
+void parse_warning(const std::string& text){
+  if(collecting_diagnostics()){
+    current_diagnostics->push_back({diagnostic_type::warning, text});
+    return;
+  }
+  Rcpp::warning(text);
+}
+
+void parse_message(const std::string& text){
+  if(collecting_diagnostics()){
+    current_diagnostics->push_back({diagnostic_type::message, text});
+    return;
+  }
+  Rcpp::Function message("message");
+  message(text);
+}
+
+void replay_diagnostics(const parse_diagnostics& diagnostics){
+  for(const diagnostic& d: diagnostics){
+    switch(d.type){
+    case diagnostic_type::warning:
+      Rcpp::warning(d.text);
+      break;
+    case diagnostic_type::message:
+      Rcpp::Function message("message");
+      message(d.text);
+      break;
+    }
+  }
+}
@@ -0,0 +1,53 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+#include <Rcpp.h>
+#include <stdexcept>
+
+// The parser reports errors, warnings, and messages through parse_stop,
+// parse_warning, and parse_message instead of calling R directly. By default,
+// everything is forwarded to R immediately. If diagnostics are collected on
+// the current thread (see collect_diagnostics), warnings and messages are
+// recorded and errors are thrown as parse_error. This allows running the
+// parser outside of R's main thread.
+
+class parse_error: public std::runtime_error{
+public:
+  explicit parse_error(const std::string& what): std::runtime_error(what){}
+};
+
+enum class diagnostic_type{warning, message};
+
+struct diagnostic{
+  diagnostic_type type;
+  std::string text;
+};
+
+typedef std::vector<diagnostic> parse_diagnostics;
+
+// records all diagnostics of the current thread in diagnostics for as long as
+// the object exists.
+class collect_diagnostics{
+public:
+  explicit collect_diagnostics(parse_diagnostics& diagnostics);
+  ~collect_diagnostics();
+
+  collect_diagnostics(const collect_diagnostics&) = delete;
+  collect_diagnostics& operator=(const collect_diagnostics&) = delete;
+
+private:
+  parse_diagnostics* previous;
+};
+
+bool collecting_diagnostics();
+
+[[noreturn]] void parse_stop(const std::string& text);
+
+void parse_warning(const std::string& text);
+
+void parse_message(const std::string& text);
+
+// forwards recorded warnings and messages to R. Must be called from R's main
+// thread.
+void replay_diagnostics(const parse_diagnostics& diagnostics);
+
+#endif
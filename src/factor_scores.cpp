@@ -0,0 +1,221 @@
+#include <Rcpp.h>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include "person_models.h"
+
+enum class score_type{regression, bartlett};
+
+// Factor scores are a linear function of the observed values of a person:
+// scores = mean_latent + weights^T (observed - mean_observed). The weights only
+// depend on the implied moments and the missingness pattern and are reused for
+// all persons with the same definition variables and missingness pattern.
+class factor_score_weights{
+public:
+  factor_score_weights(const person_model& model, const score_type type):
+  model(model), type(type){}
+
+  // returns false if the weights cannot be computed (e.g., because the implied
+  // covariance matrix of the observed variables is not positive definite)
+  bool update(const person_moments& moments, const std::size_t row){
+    observed.clear();
+    for(std::size_t m = 0; m < model.manifests.size(); m++){
+      if(!std::isnan(model.observed[m][row]))
+        observed.push_back(m);
+    }
+    const std::size_t n_observed = observed.size();
+    const std::size_t n_latent = model.latents.size();
+
+    latent_mean.resize(n_latent);
+    for(std::size_t l = 0; l < n_latent; l++)
+      latent_mean[l] = moments.mean[model.latents[l]];
+    observed_mean.resize(n_observed);
+    for(std::size_t o = 0; o < n_observed; o++)
+      observed_mean[o] = moments.mean[model.manifests[observed[o]]];
+
+    dense_matrix observed_covariance(n_observed, n_observed);
+    dense_matrix observed_latent(n_observed, n_latent);
+    for(std::size_t o = 0; o < n_observed; o++){
+      const std::size_t variable = model.manifests[observed[o]];
+      for(std::size_t p = 0; p < n_observed; p++)
+        observed_covariance(p, o) = moments.covariance(model.manifests[observed[p]], variable);
+      for(std::size_t l = 0; l < n_latent; l++)
+        observed_latent(o, l) = moments.covariance(variable, model.latents[l]);
+    }
+
+    if(type == score_type::regression){
+      // weights = Sigma_oo^-1 Sigma_ol
+      if(!cholesky(observed_covariance))
+        return(false);
+      cholesky_solve(observed_covariance, observed_latent);
+      weights = std::move(observed_latent);
+      return(true);
+    }
+
+    // Bartlett: the loadings of the observed variables on the latent variables
+    // are Lambda = Sigma_ol Phi^-1 and the residual covariances are
+    // Theta = Sigma_oo - Lambda Sigma_lo. The weights are
+    // Theta^-1 Lambda (Lambda^T Theta^-1 Lambda)^-1.
+    if(n_observed == 0)
+      return(false);
+    dense_matrix phi(n_latent, n_latent);
+    for(std::size_t l = 0; l < n_latent; l++){
+      for(std::size_t k = 0; k < n_latent; k++)
+        phi(k, l) = moments.covariance(model.latents[k], model.latents[l]);
+    }
+    if(!cholesky(phi))
+      return(false);
+    dense_matrix loadings(n_latent, n_observed);
+    for(std::size_t o = 0; o < n_observed; o++){
+      for(std::size_t l = 0; l < n_latent; l++)
+        loadings(l, o) = observed_latent(o, l);
+    }
+    cholesky_solve(phi, loadings);
+
+    dense_matrix theta = observed_covariance;
+    for(std::size_t o = 0; o < n_observed; o++){
+      for(std::size_t p = 0; p < n_observed; p++){
+        double value = 0.0;
+        for(std::size_t l = 0; l < n_latent; l++)
+          value += loadings(l, p) * observed_latent(o, l);
+        theta(p, o) -= value;
+      }
+    }
+    if(!cholesky(theta))
+      return(false);
+    // Theta^-1 Lambda
+    dense_matrix weighted(n_observed, n_latent);
+    for(std::size_t o = 0; o < n_observed; o++){
+      for(std::size_t l = 0; l < n_latent; l++)
+        weighted(o, l) = loadings(l, o);
+    }
+    cholesky_solve(theta, weighted);
+
+    dense_matrix information(n_latent, n_latent);
+    for(std::size_t l = 0; l < n_latent; l++){
+      for(std::size_t k = 0; k < n_latent; k++){
+        double value = 0.0;
+        for(std::size_t o = 0; o < n_observed; o++)
+          value += loadings(k, o) * weighted(o, l);
+        information(k, l) = value;
+      }
+    }
+    if(!cholesky(information))
+      return(false);
+    dense_matrix transposed(n_latent, n_observed);
+    for(std::size_t o = 0; o < n_observed; o++){
+      for(std::size_t l = 0; l < n_latent; l++)
+        transposed(l, o) = weighted(o, l);
+    }
+    cholesky_solve(information, transposed);
+    weights = dense_matrix(n_observed, n_latent);
+    for(std::size_t o = 0; o < n_observed; o++){
+      for(std::size_t l = 0; l < n_latent; l++)
+        weights(o, l) = transposed(l, o);
+    }
+    return(true);
+  }
+
+  double score(const std::size_t latent, const std::size_t row) const{
+    double value = latent_mean[latent];
+    for(std::size_t o = 0; o < observed.size(); o++)
+      value += weights(o, latent) * (model.observed[observed[o]][row] - observed_mean[o]);
+    return(value);
+  }
+
+private:
+  const person_model& model;
+  const score_type type;
+  // manifest variables without missing values
+  std::vector<std::size_t> observed;
+  std::vector<double> latent_mean;
+  std::vector<double> observed_mean;
+  dense_matrix weights;
+};
+
+struct factor_score_result{
+  // one column per latent variable
+  std::vector<std::vector<double>> scores;
+  std::size_t n_failed = 0;
+};
+
+static factor_score_result compute_factor_scores(const person_model& model,
+                                                 const score_type type,
+                                                 const std::size_t n_threads){
+  factor_score_result result;
+  result.scores.resize(model.latents.size(), std::vector<double>(model.n_rows, NAN));
+
+  const std::vector<std::size_t> order = model.row_order();
+  std::mutex failures_mutex;
+
+  for_each_chunk_parallel(order.size(), n_threads, [&](std::size_t first, std::size_t last){
+    person_moments moments(model);
+    factor_score_weights weights(model, type);
+    bool is_valid = false;
+    std::size_t failed = 0;
+    for(std::size_t i = first; i < last; i++){
+      const std::size_t row = order[i];
+      const bool changed = moments.set_row(row);
+      if(changed || (i == first) || !model.same_missingness(order[i - 1], row))
+        is_valid = weights.update(moments, row);
+      if(!is_valid){
+        failed++;
+        continue;
+      }
+      for(std::size_t l = 0; l < model.latents.size(); l++)
+        result.scores[l][row] = weights.score(l, row);
+    }
+    std::lock_guard<std::mutex> lock(failures_mutex);
+    result.n_failed += failed;
+  });
+  return(result);
+}
+
+//' factor_scores_rcpp
+//'
+//' computes factor scores for all persons in the data of a RAM model. Elements of
+//' the model that depend on definition variables are evaluated for each person.
+//' The implied moments and the factor score weights are only recomputed if the
+//' definition variables or the missingness pattern change between persons. To this
+//' end, the persons are processed in the order of their definition variables and
+//' missingness patterns.
+//' @param model list created with prepare_person_model
+//' @param data raw data
+//' @param type regression or Bartlett
+//' @param n_threads number of threads. Each thread processes a chunk of the persons.
+//' @return list with a matrix with one row per person and one column per latent
+//' variable (scores) and the number of persons for which the scores could not be computed
+//' (n_failed; e.g., because the implied covariance matrix is not positive definite).
+//' Scores that could not be computed are NA.
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::List factor_scores_rcpp(Rcpp::List model,
+                              Rcpp::List data,
+                              std::string type,
+                              int n_threads = 1){
+  score_type score;
+  if(type == "regression"){
+    score = score_type::regression;
+  }else if(type == "Bartlett"){
+    score = score_type::bartlett;
+  }else{
+    Rcpp::stop("Unknown type of factor scores: " + type + ". Use regression or Bartlett.");
+  }
+
+  const person_model persons(read_person_model(model, data));
+  factor_score_result result = compute_factor_scores(persons,
+                                                     score,
+                                                     static_cast<std::size_t>(std::max(n_threads, 1)));
+
+  Rcpp::NumericMatrix scores(persons.n_rows, persons.latents.size());
+  for(std::size_t l = 0; l < persons.latents.size(); l++){
+    for(std::size_t row = 0; row < persons.n_rows; row++){
+      const double value = result.scores[l][row];
+      scores(row, l) = std::isnan(value) ? NA_REAL : value;
+    }
+  }
+  scores.attr("dimnames") = Rcpp::List::create(R_NilValue, Rcpp::wrap(persons.latent_names));
+
+  return(Rcpp::List::create(Rcpp::Named("scores") = scores,
+                            Rcpp::Named("n_failed") = static_cast<int>(result.n_failed)));
+}
@@ -1,4 +1,158 @@
 #include <Rcpp.h>
+#include "model_blocks.h"
+#include "diagnostics.h"
+
+std::vector<model_block> find_model_blocks(std::string_view syntax){
+
+  std::vector<model_block> blocks;
+
+  std::size_t line_start = 0;
+  while(true){
+    std::size_t line_end = syntax.find('\n', line_start);
+    if(line_end == std::string_view::npos)
+      line_end = syntax.size();
+
+    // a header is a line with at least three equal signs. Equal signs in
+    // comments (e.g., # ==== section ====) are not headers.
+    std::string_view line = syntax.substr(line_start, line_end - line_start);
+    line = line.substr(0, line.find('#'));
+    std::size_t header_start = line.find("===");
+
+    if(header_start != std::string_view::npos){
+
+      // the previous model ends where the next header starts
+      if(!blocks.empty())
+        blocks.back().syntax_end = line_start;
+
+      model_block block;
+      for(char c: line.substr(header_start)){
+        switch(c){
+        case ' ':
+          break;
+        case '\t':
+          break;
+        case '\r':
+          break;
+        case '=':
+          break;
+        default:
+          block.name += c;
+        }
+      }
+      block.header_start = line_start;
+      block.syntax_start = line_end;
+      block.syntax_end   = syntax.size();
+      blocks.push_back(block);
+    }
+
+    if(line_end == syntax.size())
+      break;
+    line_start = line_end + 1;
+  }
+
+  if(blocks.empty())
+    blocks.push_back({"", 0, 0, syntax.size()});
+
+  return(blocks);
+}
+
+// removes comments and white space from a line
+static std::string clean_header_line(std::string_view line){
+  line = line.substr(0, line.find('#'));
+  std::string cleaned_line;
+  for(char c: line){
+    if((c != ' ') && (c != '\t') && (c != '\r'))
+      cleaned_line += c;
+  }
+  return(cleaned_line);
+}
+
+// checks if a cleaned line starts with a keyword such as group: that is not
+// part of an algebra (e.g., group := ...)
+static bool is_keyword_line(const std::string& cleaned_line, std::string_view keyword){
+  return((cleaned_line.compare(0, keyword.size(), keyword) == 0) &&
+         (cleaned_line.compare(keyword.size(), 1, "=") != 0));
+}
+
+std::vector<model_block> find_group_blocks(std::string_view syntax){
+
+  std::vector<model_block> blocks;
+  bool has_ungrouped_syntax = false;
+
+  std::size_t line_start = 0;
+  while(true){
+    std::size_t line_end = syntax.find('\n', line_start);
+    if(line_end == std::string_view::npos)
+      line_end = syntax.size();
+
+    const std::string cleaned_line = clean_header_line(syntax.substr(line_start, line_end - line_start));
+
+    // group: name starts a new group; group := ... is an algebra
+    const bool is_header = is_keyword_line(cleaned_line, "group:");
+
+    if(is_header){
+      // all elements of a multi-group model must belong to a group
+      if(has_ungrouped_syntax)
+        parse_stop("Found syntax before the first group header (" + cleaned_line +
+          "). All parts of a multi-group model must be specified within a group.");
+
+      if(!blocks.empty())
+        blocks.back().syntax_end = line_start;
+
+      model_block block;
+      block.name = cleaned_line.substr(6);
+      if(block.name.empty())
+        parse_stop("Found a group header without a group name. Groups are specified as group: group_name.");
+      block.header_start = line_start;
+      block.syntax_start = line_end;
+      block.syntax_end   = syntax.size();
+      blocks.push_back(block);
+    }else if(blocks.empty() && !cleaned_line.empty()){
+      has_ungrouped_syntax = true;
+    }
+
+    if(line_end == syntax.size())
+      break;
+    line_start = line_end + 1;
+  }
+
+  if(blocks.empty())
+    blocks.push_back({"", 0, 0, syntax.size()});
+
+  return(blocks);
+}
+
+std::vector<model_block> find_include_lines(std::string_view syntax){
+
+  std::vector<model_block> includes;
+
+  std::size_t line_start = 0;
+  while(true){
+    std::size_t line_end = syntax.find('\n', line_start);
+    if(line_end == std::string_view::npos)
+      line_end = syntax.size();
+
+    const std::string cleaned_line = clean_header_line(syntax.substr(line_start, line_end - line_start));
+
+    // include: name inserts a module; include := ... is an algebra
+    if(is_keyword_line(cleaned_line, "include:")){
+      model_block include;
+      include.name = cleaned_line.substr(8);
+      if(include.name.empty())
+        parse_stop("Found an include without a module name. Modules are included as include: module_name.");
+      include.header_start = line_start;
+      include.syntax_start = line_end;
+      include.syntax_end   = line_end;
+      includes.push_back(include);
+    }
+
+    if(line_end == syntax.size())
+      break;
+    line_start = line_end + 1;
+  }
+
+  return(includes);
+}
 
 //' find_model_name
 //'
@@ -9,60 +163,20 @@
 // [[Rcpp::export]]
 Rcpp::List find_model_name(const std::string& syntax){
 
-   unsigned int loc{0};
-   int n_equals{0}; // counts the number of equal signs in a line.
-   unsigned int name_start{0}, name_end{0};
-   bool found_start = false;
-
-   for(char c: syntax){
-     if(!found_start){
-       // search for = signs
-       switch(c){
-       case '=':
-         n_equals++;
-         break;
-       default:
-         // reset
-         n_equals = 0;
-       break;
-       }
-     }else{
-       // search for name end
-       if(c == '\n'){
-         name_end = loc;
-         break;
-       }
-       loc++;
-       continue;
-     }
-
-     if(n_equals >= 3){
-       found_start = true;
-       name_start  = loc - n_equals;
-     }
-
-     loc++;
-   }
+   std::vector<model_block> blocks = find_model_blocks(syntax);
 
-   std::string model_name;
-   if(found_start && (name_end < syntax.size()) && (name_end > name_start)){
-     std::string model_name_full = {syntax.begin() + name_start,
-                                    syntax.begin() + name_end};
-     for(char c: model_name_full){
-       switch(c){
-       case ' ':
-         break;
-       case '\n':
-         break;
-       case '=':
-         break;
-       default:
-         model_name += c;
-       }
-     }
+   if(blocks.size() > 1){
+     std::string model_names;
+     for(const model_block& block: blocks)
+       model_names += (model_names.empty() ? "" : ", ") + block.name;
+     Rcpp::stop("Found multiple models in your syntax: " + model_names +
+       ". Use mxsem_multi to set up multiple models from a single syntax.");
    }
 
-   std::string model_syntax = {syntax.begin() + name_end, syntax.end()};
+   std::string model_name = blocks.front().name;
+
+   std::string model_syntax = syntax.substr(blocks.front().syntax_start,
+                                            blocks.front().syntax_end - blocks.front().syntax_start);
 
    if(model_syntax.size() == 0){
      Rcpp::stop("Found no model in your syntax.");
@@ -74,3 +188,31 @@ Rcpp::List find_model_name(const std::string& syntax){
    ));
 
  }
+
+//' find_model_blocks_rcpp
+//'
+//' finds all models in a syntax. Each model starts with a header of the form
+//' ===model_name===.
+//' @param syntax lavaan like syntax
+//' @return data.frame with the model names and the byte offsets at which the syntax of each
+//' model starts and ends (1-based and inclusive)
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::DataFrame find_model_blocks_rcpp(const std::string& syntax){
+
+  std::vector<model_block> blocks = find_model_blocks(syntax);
+
+  Rcpp::CharacterVector model_name(blocks.size());
+  Rcpp::NumericVector syntax_start(blocks.size());
+  Rcpp::NumericVector syntax_end(blocks.size());
+
+  for(unsigned int i = 0; i < blocks.size(); i++){
+    model_name[i]   = blocks.at(i).name;
+    syntax_start[i] = blocks.at(i).syntax_start + 1;
+    syntax_end[i]   = blocks.at(i).syntax_end;
+  }
+
+  return(Rcpp::DataFrame::create(Rcpp::Named("model_name") = model_name,
+                                 Rcpp::Named("syntax_start") = syntax_start,
+                                 Rcpp::Named("syntax_end") = syntax_end));
+}
@@ -2,31 +2,25 @@
 
 variables find_variables(const parameter_table& pt){
 
-  variables vars;
-  std::vector<std::string> all_variables;
+  variables vars(pt.resource());
+  pt_column all_variables(pt.resource());
   add_unique(all_variables, pt.lhs);
   add_unique(all_variables, pt.rhs);
-  std::vector<std::string> manifests;
-  std::vector<std::string> latents;
+  pt_column manifests(pt.resource());
+  pt_column latents(pt.resource());
 
   for(unsigned int i = 0; i < pt.op.size(); i++){
     if(pt.op.at(i).compare("=~") == 0){
-      latents.push_back(pt.lhs.at(i));
+      latents.emplace_back(pt.lhs.at(i));
     }
   }
   // all variables that are not latent are manifest.
-  for(std::string av: all_variables){
+  const std::unordered_set<std::string_view> is_latent(latents.begin(), latents.end());
+  for(const pt_string& av: all_variables){
     if(av.compare("1") == 0)
       continue; // skip intercepts
-    bool is_manifest = true;
-    for(std::string lv: latents){
-      if(av.compare(lv) == 0){
-        is_manifest = false;
-        break;
-      }
-    }
-    if(is_manifest)
-      manifests.push_back(av);
+    if(is_latent.count(av) == 0)
+      manifests.emplace_back(av);
   }
 
   add_unique(vars.manifests, manifests);
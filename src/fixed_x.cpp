@@ -0,0 +1,162 @@
+#include <Rcpp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include "add_elements.h"
+#include "parameter_table.h"
+#include "r_conversion.h"
+
+// In fixed-x mode, the means, variances, and covariances of the exogenous
+// manifest variables are not estimated but fixed to their sample values. If
+// the exogenous variables are observed for all persons, these are also the
+// maximum likelihood estimates, so the fit does not change while the
+// optimizer has fewer parameters.
+
+// the parser accepts values with digits, ., and - (see parse_modifier); the
+// value is therefore written in fixed notation. The number of decimals depends
+// on the magnitude of the value so that 17 significant digits are kept (e.g.,
+// for variances of 1e-9).
+static std::string value_to_modifier(const double value){
+  int decimals = 16;
+  if((value != 0.0) && std::isfinite(value))
+    decimals = std::max(0, 16 - static_cast<int>(std::floor(std::log10(std::fabs(value)))));
+  const int size = std::snprintf(nullptr, 0, "%.*f", decimals, value);
+  std::string modifier(size + 1, '\0');
+  std::snprintf(&modifier[0], modifier.size(), "%.*f", decimals, value);
+  modifier.resize(size);
+  return(modifier);
+}
+
+//' fixed_x_rcpp
+//'
+//' finds the means, variances, and covariances of exogenous manifest variables in
+//' a parameter table and computes the values they are fixed to in fixed-x mode.
+//' A manifest variable is exogenous if it is neither an indicator of a latent
+//' variable nor predicted by another variable (see add_covariances). Only rows
+//' without modifier (i.e., without label or value) are fixed.
+//' @param lhs left hand side of the parameter table
+//' @param op operators of the parameter table
+//' @param rhs right hand side of the parameter table
+//' @param modifier modifiers of the parameter table
+//' @param manifests names of the manifest variables
+//' @param data raw data or a matrix with the observed covariances (with dimnames). The
+//' covariances are used directly; means cannot be fixed with a covariance matrix.
+//' @param unbiased if TRUE, the covariances are divided by N-1 (as in stats::cov),
+//' otherwise by N (maximum likelihood)
+//' @return list with the rows (1-based) of the parameter table that are fixed, their
+//' new modifiers (the sample values), and the names of the exogenous manifest variables
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::List fixed_x_rcpp(const std::vector<std::string>& lhs,
+                        const std::vector<std::string>& op,
+                        const std::vector<std::string>& rhs,
+                        const std::vector<std::string>& modifier,
+                        const std::vector<std::string>& manifests,
+                        SEXP data,
+                        bool unbiased = false){
+  std::pmr::monotonic_buffer_resource arena;
+  parameter_table pt(&arena);
+  for(std::size_t i = 0; i < lhs.size(); i++){
+    pt.add_line();
+    pt.lhs.back() = lhs.at(i);
+    pt.op.back() = op.at(i);
+    pt.rhs.back() = rhs.at(i);
+  }
+  pt_column manifest_column(&arena);
+  for(const std::string& manifest: manifests)
+    manifest_column.emplace_back(manifest);
+
+  const pt_column exogenous = find_exogenous(manifest_column, pt);
+  std::unordered_map<std::string_view, std::size_t> exogenous_index;
+  for(std::size_t e = 0; e < exogenous.size(); e++)
+    exogenous_index[exogenous.at(e)] = e;
+
+  // the sample values are only computed for variables with rows that are fixed
+  std::vector<std::size_t> rows;
+  for(std::size_t i = 0; i < pt.lhs.size(); i++){
+    if(!modifier.at(i).empty())
+      continue;
+    const bool is_exogenous_lhs = exogenous_index.count(pt.lhs.at(i)) > 0;
+    const bool is_mean = (pt.op.at(i).compare("~") == 0) && (pt.rhs.at(i).compare("1") == 0);
+    const bool is_covariance = (pt.op.at(i).compare("~~") == 0) &&
+      (exogenous_index.count(pt.rhs.at(i)) > 0);
+    if(is_exogenous_lhs && (is_mean || is_covariance))
+      rows.push_back(i);
+  }
+
+  // data files are reduced to their observed covariances if the model has no
+  // intercepts (see read_data_file); the values are then taken from this matrix
+  const bool is_covariance_matrix = Rf_isMatrix(data);
+  std::unordered_map<std::string_view, std::size_t> covariance_index;
+  if(is_covariance_matrix){
+    SEXP dimnames = Rf_getAttrib(data, R_DimNamesSymbol);
+    if((dimnames == R_NilValue) || (VECTOR_ELT(dimnames, 1) == R_NilValue))
+      Rcpp::stop("The observed covariances must have row and column names.");
+    SEXP names = VECTOR_ELT(dimnames, 1);
+    for(R_xlen_t i = 0; i < Rf_xlength(names); i++)
+      covariance_index.emplace(CHAR(STRING_ELT(names, i)), i);
+  }
+  auto observed_covariance = [&](std::string_view x, std::string_view y) -> double {
+    auto row = covariance_index.find(x);
+    auto col = covariance_index.find(y);
+    if((row == covariance_index.end()) || (col == covariance_index.end()))
+      Rcpp::stop("Could not find the variable " + std::string(row == covariance_index.end() ? x : y) +
+        " in the observed covariances.");
+    return(REAL(data)[row->second + col->second * Rf_nrows(data)]);
+  };
+
+  std::vector<std::vector<double>> values(exogenous.size());
+  std::vector<double> means(exogenous.size(), NAN);
+  std::size_t n_rows = 0;
+  auto read_variable = [&](std::string_view name) -> std::size_t {
+    const std::size_t e = exogenous_index.at(name);
+    if(!values.at(e).empty())
+      return(e);
+    values.at(e) = read_numeric_column(Rcpp::List(data), std::string(name));
+    n_rows = values.at(e).size();
+    double sum = 0.0;
+    for(const double value: values.at(e)){
+      if(std::isnan(value))
+        Rcpp::stop("The exogenous variable " + std::string(name) +
+          " has missing values. fixed_x requires that exogenous manifest variables are observed for all persons.");
+      sum += value;
+    }
+    means.at(e) = sum / static_cast<double>(n_rows);
+    return(e);
+  };
+
+  Rcpp::IntegerVector fixed_rows(rows.size());
+  Rcpp::CharacterVector fixed_modifiers(rows.size());
+  for(std::size_t r = 0; r < rows.size(); r++){
+    const std::size_t i = rows.at(r);
+    fixed_rows[r] = static_cast<int>(i + 1);
+    if(is_covariance_matrix){
+      if(pt.op.at(i).compare("~~") != 0)
+        Rcpp::stop("fixed_x requires the raw data to fix the mean of " + std::string(pt.lhs.at(i)) + ".");
+      fixed_modifiers[r] = value_to_modifier(observed_covariance(pt.lhs.at(i), pt.rhs.at(i)));
+      continue;
+    }
+    const std::size_t x = read_variable(pt.lhs.at(i));
+    double value = means.at(x);
+    if(pt.op.at(i).compare("~~") == 0){
+      const std::size_t y = read_variable(pt.rhs.at(i));
+      if(n_rows < 2)
+        Rcpp::stop("fixed_x requires at least two persons in the data.");
+      double sum = 0.0;
+      for(std::size_t row = 0; row < n_rows; row++)
+        sum += (values.at(x)[row] - means.at(x)) * (values.at(y)[row] - means.at(y));
+      value = sum / static_cast<double>(unbiased ? n_rows - 1 : n_rows);
+    }
+    fixed_modifiers[r] = value_to_modifier(value);
+  }
+
+  Rcpp::CharacterVector exogenous_names(exogenous.size());
+  for(std::size_t e = 0; e < exogenous.size(); e++)
+    exogenous_names[e] = std::string(exogenous.at(e));
+
+  return(Rcpp::List::create(Rcpp::Named("row") = fixed_rows,
+                            Rcpp::Named("modifier") = fixed_modifiers,
+                            Rcpp::Named("exogenous") = exogenous_names));
+}
@@ -0,0 +1,197 @@
+#include <Rcpp.h>
+#include <algorithm>
+#include "make_parameter_table.h"
+#include "model_blocks.h"
+#include "groups.h"
+#include "diagnostics.h"
+#include "r_conversion.h"
+#include "string_operations.h"
+#include "check_syntax.h"
+
+bool is_group_modifier(std::string_view modifier){
+  return((modifier.size() > 3) &&
+         (modifier.compare(0, 2, "c(") == 0) &&
+         (modifier.back() == ')'));
+}
+
+std::pmr::vector<std::string_view> group_modifier_elements(std::string_view modifier,
+                                                           std::pmr::memory_resource* mr){
+  return(split_string_all(modifier.substr(2, modifier.size() - 3), ',', mr));
+}
+
+std::size_t count_groups(const parameter_table& pt){
+  std::size_t n_groups = 1;
+  for(const pt_string& modifier: pt.modifier){
+    if(is_group_modifier(modifier))
+      n_groups = std::max(n_groups,
+                          group_modifier_elements(modifier, pt.resource()).size());
+  }
+  return(n_groups);
+}
+
+void select_group_modifiers(parameter_table& pt,
+                            std::size_t group,
+                            std::size_t n_groups){
+  for(pt_string& modifier: pt.modifier){
+    if(!is_group_modifier(modifier))
+      continue;
+
+    std::pmr::vector<std::string_view> elements = group_modifier_elements(modifier, pt.resource());
+
+    if(elements.size() != n_groups)
+      parse_stop("The group specific modifier " + std::string(modifier) + " has " +
+        std::to_string(elements.size()) + " element(s), but the model has " +
+        std::to_string(n_groups) + " group(s)." +
+        (n_groups == 1 ? " Use mxsem_groups to set up multi-group models." : ""));
+
+    std::string_view element = elements.at(group);
+    if(element.empty())
+      parse_stop("Found an empty element in the group specific modifier " + std::string(modifier) + ".");
+    // NA: the parameter of this group gets no label
+    if(element.compare("NA") == 0)
+      element = std::string_view();
+    check_modifier(element);
+    // element is a view into modifier
+    modifier = pt_string(element, pt.resource());
+  }
+}
+
+// copies the paths and user defined elements found in the first stage of the
+// parser (see parse_equations) to the parameter table of a group
+static void copy_equations(const parameter_table& from,
+                           parameter_table& to){
+  to.lhs = from.lhs;
+  to.op = from.op;
+  to.rhs = from.rhs;
+  to.modifier = from.modifier;
+  to.lbound = from.lbound;
+  to.ubound = from.ubound;
+  to.free = from.free;
+  to.user_defined = from.user_defined;
+}
+
+static Rcpp::List add_group_column(Rcpp::List parameter_table,
+                                   const int group){
+  Rcpp::List rows = parameter_table["parameter_table"];
+  const R_xlen_t n_rows = Rf_xlength(VECTOR_ELT(rows, 0));
+
+  Rcpp::List columns(rows.size() + 1);
+  Rcpp::CharacterVector column_names(rows.size() + 1);
+  Rcpp::CharacterVector row_column_names(rows.names());
+  for(R_xlen_t i = 0; i < rows.size(); i++){
+    columns[i] = VECTOR_ELT(rows, i);
+    column_names[i] = row_column_names[i];
+  }
+  columns[rows.size()] = Rcpp::IntegerVector(n_rows, group);
+  column_names[rows.size()] = "group";
+
+  parameter_table["parameter_table"] = make_data_frame(columns, column_names, n_rows);
+  return(parameter_table);
+}
+
+//' parameter_table_groups_rcpp
+//'
+//' creates the parameter tables of a multi-group model from a lavaan like syntax.
+//' Groups can be specified in two ways: (1) The syntax is split in blocks, each starting
+//' with a header of the form group: group_name, or (2) the syntax is shared by all groups
+//' and group specific modifiers (e.g., c(a1, a2)*y1) assign a label or value to each group.
+//' In the second case, the syntax is only parsed once and the parameter tables
+//' of all groups are derived from the parsed syntax.
+//' @param syntax lavaan like syntax
+//' @param n_groups number of groups. Set to 0 to use the number of group blocks or
+//' the number of elements in the group specific modifiers.
+//' @param add_intercept should intercepts for manifest variables be automatically added?
+//' @param add_variance should variances for all variables be automatically added?
+//' @param add_exogenous_latent_covariances should covariances between exogenous latent variables be
+//' added automatically?
+//' @param add_exogenous_manifest_covariances should covariances between exogenous manifest variables be
+//' added automatically?
+//' @param scale_latent_variance should variances of latent variables be set to 1?
+//' @param scale_loading should the first loading of each latent variable be set to 1?
+//' @return list with the names of the group blocks (group_names; empty strings if the syntax
+//' has no group blocks) and one parameter table (see parameter_table_rcpp) per group
+//' (parameter_tables). The parameter_table of each group has an additional column
+//' with the group index.
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::List parameter_table_groups_rcpp(const std::string& syntax,
+                                       int n_groups,
+                                       bool add_intercept,
+                                       bool add_variance,
+                                       bool add_exogenous_latent_covariances,
+                                       bool add_exogenous_manifest_covariances,
+                                       bool scale_latent_variance,
+                                       bool scale_loading){
+
+  if(n_groups < 0)
+    Rcpp::stop("n_groups must be non-negative.");
+
+  const std::vector<model_block> blocks = find_group_blocks(syntax);
+  const bool has_group_blocks = !blocks.front().name.empty();
+
+  std::pmr::monotonic_buffer_resource arena(4 * syntax.size() + 1024);
+  std::vector<parameter_table> tables;
+  std::vector<std::string> group_names;
+
+  if(has_group_blocks){
+    if((n_groups != 0) && (static_cast<std::size_t>(n_groups) != blocks.size()))
+      Rcpp::stop("The syntax has " + std::to_string(blocks.size()) + " groups, but the data has " +
+        std::to_string(n_groups) + " groups.");
+
+    // each group has its own syntax
+    for(std::size_t b = 0; b < blocks.size(); b++){
+      for(std::size_t other = 0; other < b; other++){
+        if(blocks.at(b).name.compare(blocks.at(other).name) == 0)
+          Rcpp::stop("Found multiple groups with the name " + blocks.at(b).name + ".");
+      }
+      std::string_view block_syntax = std::string_view(syntax).substr(
+        blocks.at(b).syntax_start,
+        blocks.at(b).syntax_end - blocks.at(b).syntax_start);
+
+      parameter_table pt(&arena);
+      const pt_column equations = parse_equations(block_syntax, pt);
+      if(pt.lhs.empty() && pt.user_defined.empty())
+        Rcpp::stop("Found no model in your syntax for group " + blocks.at(b).name + ".");
+      complete_parameter_table(equations, pt, b, blocks.size(),
+                               add_intercept,
+                               add_variance,
+                               add_exogenous_latent_covariances,
+                               add_exogenous_manifest_covariances,
+                               scale_latent_variance,
+                               scale_loading);
+      tables.push_back(std::move(pt));
+      group_names.push_back(blocks.at(b).name);
+    }
+  }else{
+    // all groups share the syntax: the syntax is parsed once and only the
+    // group specific parts are repeated for each group
+    parameter_table shared(&arena);
+    const pt_column equations = parse_equations(syntax, shared);
+
+    const std::size_t n = (n_groups == 0) ? count_groups(shared) : static_cast<std::size_t>(n_groups);
+
+    for(std::size_t g = 0; g < n; g++){
+      parameter_table pt(&arena);
+      copy_equations(shared, pt);
+      complete_parameter_table(equations, pt, g, n,
+                               add_intercept,
+                               add_variance,
+                               add_exogenous_latent_covariances,
+                               add_exogenous_manifest_covariances,
+                               scale_latent_variance,
+                               scale_loading);
+      tables.push_back(std::move(pt));
+      group_names.push_back("");
+    }
+  }
+
+  // The arena must outlive the conversion: the cached R strings are looked up
+  // by views into the parameter tables.
+  Rcpp::List parameter_tables(tables.size());
+  for(std::size_t g = 0; g < tables.size(); g++)
+    parameter_tables[g] = add_group_column(parameter_table_to_r(tables.at(g)),
+                                           static_cast<int>(g + 1));
+
+  return(Rcpp::List::create(Rcpp::Named("group_names") = group_names,
+                            Rcpp::Named("parameter_tables") = parameter_tables));
+}
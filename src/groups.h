@@ -0,0 +1,26 @@
+#ifndef GROUPS_H
+#define GROUPS_H
+#include <Rcpp.h>
+#include <string_view>
+#include "parameter_table.h"
+
+// Group specific modifiers assign one label or value to each group of a
+// multi-group model (e.g., c(a1, a2)*y1). NA leaves the parameter of a group
+// unlabeled.
+bool is_group_modifier(std::string_view modifier);
+
+// elements of a group specific modifier. The elements are views into modifier.
+std::pmr::vector<std::string_view> group_modifier_elements(std::string_view modifier,
+                                                           std::pmr::memory_resource* mr);
+
+// largest number of elements in the group specific modifiers of the table;
+// 1 if there are none.
+std::size_t count_groups(const parameter_table& pt);
+
+// replaces all group specific modifiers with their element for group (0-based).
+// Throws if the number of elements differs from n_groups.
+void select_group_modifiers(parameter_table& pt,
+                            std::size_t group,
+                            std::size_t n_groups);
+
+#endif
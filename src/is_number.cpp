@@ -1,7 +1,7 @@
 #include "string_operations.h"
 #include <cctype>
 
-bool is_number(const std::string& str){
+bool is_number(std::string_view str){
 
   if(str.size() <= 0)
     return(false);
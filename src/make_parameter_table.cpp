@@ -1,4 +1,7 @@
 #include <Rcpp.h>
+#include <algorithm>
+#include <memory>
+#include <thread>
 #include "string_operations.h"
 #include "clean_syntax.h"
 #include "check_syntax.h"
@@ -7,35 +10,48 @@
 #include "add_elements.h"
 #include "find_variables.h"
 #include "scale_latent_variables.h"
-
-void add_user_defined(const std::vector<std::string>& equations,
+#include "r_conversion.h"
+#include "make_parameter_table.h"
+#include "model_handle.h"
+#include "diagnostics.h"
+#include "groups.h"
+#include "model_blocks.h"
+#include "modules.h"
+
+void add_user_defined(const pt_column& equations,
+                      std::size_t first,
+                      std::size_t last,
                       parameter_table& pt){
-  for(std::string eq: equations){
+  for(std::size_t e = first; e < last; e++){
+    const pt_string& eq = equations[e];
 
     // if this is a user specified special element in curly braces, we
     // add it to the parameter table
     if(eq[0] == '{'){
-      pt.user_defined.push_back(eq);
+      pt.user_defined.emplace_back(eq);
       }
 
   }
 }
 
-void add_effects(const std::vector<std::string>& equations,
+void add_effects(const pt_column& equations,
+                 std::size_t first,
+                 std::size_t last,
                  parameter_table& pt){
 
   equation_elements eq_elem;
 
-  for(std::string eq: equations){
+  static constexpr std::string_view check_for[] = {"=~", "~~", "~"};
+
+  for(std::size_t e = first; e < last; e++){
+    const pt_string& eq = equations[e];
 
     // if this is a user specified special element in curly braces, we skip the
     // rest
     if(eq[0] == '{')
       continue;
 
-    std::vector<std::string> check_for = {"=~", "~~", "~"};
-
-    for(std::string c_for: check_for){
+    for(std::string_view c_for: check_for){
 
       if(eq.find(c_for) != std::string::npos){
 
@@ -45,7 +61,8 @@ void add_effects(const std::vector<std::string>& equations,
 
         check_lhs(eq_elem.lhs);
 
-        std::vector<str_rhs_elem> rhs_elems = split_eqation_rhs(eq_elem.rhs);
+        std::pmr::vector<str_rhs_elem> rhs_elems = split_eqation_rhs(eq_elem.rhs,
+                                                                     pt.resource());
 
         for(auto& rhs_elem: rhs_elems){
 
@@ -65,53 +82,10 @@ void add_effects(const std::vector<std::string>& equations,
   }
 }
 
-void add_bounds(const std::vector<std::string>& equations,
-                parameter_table& pt){
-
-  equation_elements eq_elem;
-  // we now check for bounds. These should be added to parameters which is
-  // why we first looked for the loadings, etc.
-  for(std::string eq: equations){
-
-    // if this is a user specified special element in curly braces, we skip the
-    // rest
-    if(eq[0] == '{')
-      continue;
-
-    std::vector<std::string> check_for = {">", "<"};
-
-    for(std::string c_for: check_for){
-
-      if(eq.find(c_for) != std::string::npos){
-
-        equation_elements eq_elem = split_string_once(eq, c_for);
-
-        bool was_found = false;
-        for(unsigned int i = 0; i < pt.modifier.size(); i++){
-
-          if(pt.modifier.at(i).compare(eq_elem.lhs) == 0){
-            was_found = true;
-            if(c_for.compare(">") == 0)
-              pt.lbound.at(i) = eq_elem.rhs;
-            if(c_for.compare("<") == 0)
-              pt.ubound.at(i) = eq_elem.rhs;
-          }
-
-        }
-
-        if(!was_found)
-          Rcpp::stop("Found a constraint on the following parameter: " + eq_elem.lhs +
-            ", but could not find this parameter in your model.");
-      }
-    }
-
-  }
-}
-
-std::string remove_outer_braces(const std::string str){
+std::string_view remove_outer_braces(std::string_view str){
 
   if((str[0] != '{') || (str[str.size()-1] != '}')){
-    Rcpp::stop( str + " has unbalanced curly braces");
+    parse_stop(std::string(str) + " has unbalanced curly braces");
   }
 
   return(str.substr(1, str.size() - 2));
@@ -142,30 +116,174 @@ bool pt_remove_outer_braces(parameter_table& pt){
 }
 
 
-parameter_table make_parameter_table(const std::string& syntax,
-                                     bool add_intercept,
-                                     bool add_variance,
-                                     bool add_exogenous_latent_covariances,
-                                     bool add_exogenous_manifest_covariances,
-                                     bool scale_latent_variance,
-                                     bool scale_loading){
+// Each equation is parsed independently in the first stage. Large syntaxes
+// are therefore split in chunks of equations that are parsed on separate
+// threads, each into a parameter table with its own arena. The chunks are
+// merged in the order of the equations, so the parameter table does not depend
+// on the number of threads.
+static constexpr std::size_t min_equations_per_chunk = 1024;
+
+struct equation_chunk{
+  std::unique_ptr<std::pmr::monotonic_buffer_resource> arena;
+  std::unique_ptr<parameter_table> pt;
+  parse_diagnostics diagnostics;
+  std::string error;
+  bool failed = false;
+};
+
+template<class T>
+static void append_column(T& to, const T& from){
+  to.insert(to.end(), from.begin(), from.end());
+}
+
+// appends the rows and user defined elements of the first stage. Strings are
+// copied into the arena of to.
+static void append_parameter_table(parameter_table& to, const parameter_table& from){
+  append_column(to.user_defined, from.user_defined);
+  append_column(to.lhs, from.lhs);
+  append_column(to.op, from.op);
+  append_column(to.rhs, from.rhs);
+  append_column(to.modifier, from.modifier);
+  append_column(to.lbound, from.lbound);
+  append_column(to.ubound, from.ubound);
+  append_column(to.free, from.free);
+}
 
-  const std::vector<std::string> equations = clean_syntax(syntax);
+static void add_equations_parallel(const pt_column& equations,
+                                   parameter_table& pt,
+                                   std::size_t n_chunks){
+  std::vector<equation_chunk> chunks(n_chunks);
+
+  auto parse_chunk = [&](std::size_t c){
+    const std::size_t first = c * equations.size() / n_chunks;
+    const std::size_t last = (c + 1) * equations.size() / n_chunks;
+    equation_chunk& chunk = chunks.at(c);
+
+    // the parser must not call R outside of the main thread
+    collect_diagnostics collect(chunk.diagnostics);
+    try{
+      std::size_t n_chars = 0;
+      for(std::size_t e = first; e < last; e++)
+        n_chars += equations[e].size();
+      chunk.arena = std::make_unique<std::pmr::monotonic_buffer_resource>(4 * n_chars + 1024);
+      chunk.pt = std::make_unique<parameter_table>(chunk.arena.get());
+      add_user_defined(equations, first, last, *chunk.pt);
+      add_effects(equations, first, last, *chunk.pt);
+    }catch(const std::exception& e){
+      chunk.failed = true;
+      chunk.error = e.what();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for(std::size_t c = 1; c < n_chunks; c++)
+    workers.emplace_back(parse_chunk, c);
+  parse_chunk(0);
+  for(std::thread& worker: workers)
+    worker.join();
+
+  // diagnostics and errors are reported in the same order as in a sequential
+  // parse: everything up to the first chunk with an error.
+  for(const equation_chunk& chunk: chunks){
+    for(const diagnostic& d: chunk.diagnostics){
+      if(d.type == diagnostic_type::warning)
+        parse_warning(d.text);
+      else
+        parse_message(d.text);
+    }
+    if(chunk.failed)
+      parse_stop(chunk.error);
+  }
+
+  for(const equation_chunk& chunk: chunks)
+    append_parameter_table(pt, *chunk.pt);
+}
+
+static pt_column parse_syntax_equations(std::string_view syntax,
+                                        parameter_table& pt,
+                                        std::size_t n_threads){
+
+  pt_column equations = clean_syntax(syntax, pt.resource());
 
   check_cleaned(equations);
 
-  parameter_table pt;
+  const std::size_t n_chunks = std::min(std::max<std::size_t>(n_threads, 1),
+                                        equations.size() / min_equations_per_chunk);
+
+  if(n_chunks > 1){
+    add_equations_parallel(equations, pt, n_chunks);
+    return(equations);
+  }
+
+  add_user_defined(equations, 0, equations.size(), pt);
+
+  add_effects(equations, 0, equations.size(), pt);
+
+  return(equations);
+}
+
+pt_column parse_equations(std::string_view syntax,
+                          parameter_table& pt,
+                          std::size_t n_threads){
+
+  const std::vector<model_block> includes = syntax.find("include") == std::string_view::npos ?
+    std::vector<model_block>() :
+    find_include_lines(syntax);
+  if(includes.empty())
+    return(parse_syntax_equations(syntax, pt, n_threads));
+
+  // the parsed rows of each module are inserted at the position of the
+  // include line. Variances, covariances, etc. are only added in the second
+  // stage, once for the combined model.
+  pt_column equations(pt.resource());
+  std::size_t start = 0;
+  for(const model_block& include: includes){
+    append_column(equations, parse_syntax_equations(syntax.substr(start, include.header_start - start),
+                                                    pt,
+                                                    n_threads));
+
+    const std::shared_ptr<const parsed_module> module = find_module(include.name);
+    for(const diagnostic& d: module->diagnostics){
+      if(d.type == diagnostic_type::warning)
+        parse_warning(d.text);
+      else
+        parse_message(d.text);
+    }
+    append_parameter_table(pt, module->pt);
+    append_column(equations, module->equations);
+
+    start = include.syntax_start;
+  }
+  append_column(equations, parse_syntax_equations(syntax.substr(start), pt, n_threads));
+
+  return(equations);
+}
 
-  add_user_defined(equations, pt);
+void complete_parameter_table(const pt_column& equations,
+                              parameter_table& pt,
+                              std::size_t group,
+                              std::size_t n_groups,
+                              bool add_intercept,
+                              bool add_variance,
+                              bool add_exogenous_latent_covariances,
+                              bool add_exogenous_manifest_covariances,
+                              bool scale_latent_variance,
+                              bool scale_loading){
 
-  add_effects(equations, pt);
+  add_bounds(equations, pt, group);
 
-  add_bounds(equations, pt);
+  // group specific modifiers (e.g., c(a1, a2)*y1) are replaced with the
+  // element of this group before the algebras refer to the labels
+  select_group_modifiers(pt, group, n_groups);
 
   // Now add transformations (mxAlgebra)
   make_algebras(equations,
                 pt);
 
+  // equality constraints (a == b) become shared labels
+  add_equalities(equations,
+                 pt);
+
   // clean user defined elements: remove outer braces
   // bool has_curly = pt_remove_outer_braces(pt);
   // if(has_curly)
@@ -189,6 +307,38 @@ parameter_table make_parameter_table(const std::string& syntax,
   if(scale_loading)
     scale_loadings(pt);
 
+  // bounds on categories (e.g., variances(manifest) > 0) also apply to the
+  // elements that were added automatically
+  add_category_bounds(equations, pt);
+
+  check_fields(pt);
+}
+
+parameter_table make_parameter_table(std::string_view syntax,
+                                     std::pmr::memory_resource* mr,
+                                     bool add_intercept,
+                                     bool add_variance,
+                                     bool add_exogenous_latent_covariances,
+                                     bool add_exogenous_manifest_covariances,
+                                     bool scale_latent_variance,
+                                     bool scale_loading,
+                                     std::size_t n_threads){
+
+  parameter_table pt(mr);
+
+  const pt_column equations = parse_equations(syntax, pt, n_threads);
+
+  complete_parameter_table(equations,
+                           pt,
+                           0,
+                           1,
+                           add_intercept,
+                           add_variance,
+                           add_exogenous_latent_covariances,
+                           add_exogenous_manifest_covariances,
+                           scale_latent_variance,
+                           scale_loading);
+
   return(pt);
 }
 
@@ -204,44 +354,60 @@ parameter_table make_parameter_table(const std::string& syntax,
 //' added automatically?
 //' @param scale_latent_variance should variances of latent variables be set to 1?
 //' @param scale_loading should the first loading of each latent variable be set to 1?
-//' @return parameter table
+//' @param return_handle if TRUE, an external pointer to the parsed model is returned
+//' instead of the list. Use handle_parameter_table and handle_to_list to access
+//' the model.
+//' @param n_threads number of threads used to parse large syntaxes. The equations are
+//' split in chunks that are parsed in parallel.
+//' @return parameter table. In the parameter table, op is a factor and free is logical.
 // [[Rcpp::export]]
-Rcpp::List parameter_table_rcpp(const std::string& syntax,
-                               bool add_intercept,
-                               bool add_variance,
-                               bool add_exogenous_latent_covariances,
-                               bool add_exogenous_manifest_covariances,
-                               bool scale_latent_variance,
-                               bool scale_loading){
+SEXP parameter_table_rcpp(const std::string& syntax,
+                          bool add_intercept,
+                          bool add_variance,
+                          bool add_exogenous_latent_covariances,
+                          bool add_exogenous_manifest_covariances,
+                          bool scale_latent_variance,
+                          bool scale_loading,
+                          bool return_handle = false,
+                          int n_threads = 1){
+   if(return_handle){
+     // the handle owns the arena; it is released when R garbage collects
+     // the handle.
+     Rcpp::XPtr<model_handle> model(new model_handle(4 * syntax.size() + 1024), true);
+     model->pt = make_parameter_table(syntax,
+                                      &model->arena,
+                                      add_intercept,
+                                      add_variance,
+                                      add_exogenous_latent_covariances,
+                                      add_exogenous_manifest_covariances,
+                                      scale_latent_variance,
+                                      scale_loading,
+                                      std::max(n_threads, 1));
+     model->settings = {add_intercept,
+                        add_variance,
+                        add_exogenous_latent_covariances,
+                        add_exogenous_manifest_covariances,
+                        scale_latent_variance,
+                        scale_loading};
+     model.attr("class") = "mxsem_model_handle";
+     return(model);
+   }
+
+   // every allocation of this parse is served by the arena. The arena is
+   // released in one step when we return, after the table was copied to R.
+   std::pmr::monotonic_buffer_resource arena(4 * syntax.size() + 1024);
+
    parameter_table pt = make_parameter_table(syntax,
+                                             &arena,
                                              add_intercept,
                                              add_variance,
                                              add_exogenous_latent_covariances,
                                              add_exogenous_manifest_covariances,
                                              scale_latent_variance,
-                                             scale_loading);
-
-   Rcpp::DataFrame pt_Rcpp = Rcpp::DataFrame::create(Rcpp::Named("lhs") = pt.lhs,
-                                                     Rcpp::Named("op") = pt.op,
-                                                     Rcpp::Named("rhs") = pt.rhs,
-                                                     Rcpp::Named("modifier") = pt.modifier,
-                                                     Rcpp::Named("lbound") = pt.lbound,
-                                                     Rcpp::Named("ubound") = pt.ubound,
-                                                     Rcpp::Named("free") = pt.free);
-   Rcpp::DataFrame pt_algebras = Rcpp::DataFrame::create(Rcpp::Named("lhs") = pt.alg.lhs,
-                                                         Rcpp::Named("op") = pt.alg.op,
-                                                         Rcpp::Named("rhs") = pt.alg.rhs);
-   Rcpp::List pt_variables = Rcpp::List::create(Rcpp::Named("manifests") = pt.vars.manifests,
-                                                Rcpp::Named("latents") = pt.vars.latents);
-
-   Rcpp::List combined = Rcpp::List::create(
-     Rcpp::Named("parameter_table") = pt_Rcpp,
-     Rcpp::Named("user_defined") = pt.user_defined,
-     Rcpp::Named("algebras") = pt_algebras,
-     Rcpp::Named("variables") = pt_variables,
-     Rcpp::Named("new_parameters") = pt.alg.new_parameters,
-     Rcpp::Named("new_parameters_free") = pt.alg.new_parameters_free
-   );
-
-   return(combined);
+                                             scale_loading,
+                                             std::max(n_threads, 1));
+
+   // The arena must outlive the conversion: the cached R strings are looked up
+   // by views into the parameter table.
+   return(parameter_table_to_r(pt));
  }
@@ -0,0 +1,55 @@
+#ifndef MAKE_PARAMETER_TABLE_H
+#define MAKE_PARAMETER_TABLE_H
+#include <Rcpp.h>
+#include "parameter_table.h"
+#include <string_view>
+
+// The parser runs in two stages: parse_equations cleans the syntax and adds
+// the user defined elements and paths; complete_parameter_table adds the
+// bounds, algebras, and automatically added elements for one group. Multi-group
+// models share the first stage and only run the second stage once per group.
+// The first stage of large syntaxes is split across n_threads threads.
+pt_column parse_equations(std::string_view syntax,
+                          parameter_table& pt,
+                          std::size_t n_threads = 1);
+
+void complete_parameter_table(const pt_column& equations,
+                              parameter_table& pt,
+                              std::size_t group,
+                              std::size_t n_groups,
+                              bool add_intercept,
+                              bool add_variance,
+                              bool add_exogenous_latent_covariances,
+                              bool add_exogenous_manifest_covariances,
+                              bool scale_latent_variance,
+                              bool scale_loading);
+
+parameter_table make_parameter_table(std::string_view syntax,
+                                     std::pmr::memory_resource* mr,
+                                     bool add_intercept,
+                                     bool add_variance,
+                                     bool add_exogenous_latent_covariances,
+                                     bool add_exogenous_manifest_covariances,
+                                     bool scale_latent_variance,
+                                     bool scale_loading,
+                                     std::size_t n_threads = 1);
+
+// one row of a lavaan-style parameter table. op is one of =~, ~~, ~ (paths),
+// :=, >, or <. The bounds only apply to paths; > and < set the bounds of all
+// parameters with the label lhs.
+struct partable_row{
+  std::string_view lhs, op, rhs, modifier, lbound, ubound;
+};
+
+// creates a parameter table from rows instead of a syntax. The rows are
+// validated and completed as in the second stage of the parser.
+parameter_table make_parameter_table(const std::vector<partable_row>& rows,
+                                     std::pmr::memory_resource* mr,
+                                     bool add_intercept,
+                                     bool add_variance,
+                                     bool add_exogenous_latent_covariances,
+                                     bool add_exogenous_manifest_covariances,
+                                     bool scale_latent_variance,
+                                     bool scale_loading);
+
+#endif
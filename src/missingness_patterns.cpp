@@ -0,0 +1,207 @@
+#include <Rcpp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <unordered_map>
+
+// The missingness of each row is stored as a bit set with one bit per
+// manifest variable (1 = missing). Rows with identical bit sets share a
+// pattern.
+struct missingness_result{
+  std::size_t n_words;
+  // bit sets of the patterns in the order of their first occurrence
+  std::vector<std::uint64_t> patterns;
+  std::vector<std::size_t> counts;
+  // pattern of each row (0-based)
+  std::vector<std::size_t> row_pattern;
+  // permutation of the rows (0-based); empty if the rows are not ordered
+  std::vector<std::size_t> order;
+};
+
+static std::uint64_t hash_words(const std::uint64_t* words, const std::size_t n_words){
+  // FNV-1a over the words
+  std::uint64_t hash = 14695981039346656037ULL;
+  for(std::size_t w = 0; w < n_words; w++){
+    hash ^= words[w];
+    hash *= 1099511628211ULL;
+  }
+  return(hash);
+}
+
+// definition variables are compared numerically; missing values come last
+static int compare_values(const double a, const double b){
+  const bool a_missing = std::isnan(a);
+  const bool b_missing = std::isnan(b);
+  if(a_missing || b_missing)
+    return(static_cast<int>(a_missing) - static_cast<int>(b_missing));
+  return((a > b) - (a < b));
+}
+
+static missingness_result find_missingness_patterns(const std::vector<std::uint64_t>& row_words,
+                                                    const std::size_t n_words,
+                                                    const std::size_t n_rows,
+                                                    const std::vector<std::vector<double>>& definition_values,
+                                                    const bool order_rows){
+  missingness_result result;
+  result.n_words = n_words;
+  result.row_pattern.resize(n_rows);
+
+  std::unordered_multimap<std::uint64_t, std::size_t> known_patterns;
+  for(std::size_t row = 0; row < n_rows; row++){
+    const std::uint64_t* words = row_words.data() + row * n_words;
+    const std::uint64_t hash = hash_words(words, n_words);
+
+    std::size_t pattern = result.counts.size();
+    auto candidates = known_patterns.equal_range(hash);
+    for(auto candidate = candidates.first; candidate != candidates.second; ++candidate){
+      if(std::equal(words, words + n_words,
+                    result.patterns.begin() + candidate->second * n_words)){
+        pattern = candidate->second;
+        break;
+      }
+    }
+    if(pattern == result.counts.size()){
+      known_patterns.emplace(hash, pattern);
+      result.patterns.insert(result.patterns.end(), words, words + n_words);
+      result.counts.push_back(0);
+    }
+    result.counts[pattern]++;
+    result.row_pattern[row] = pattern;
+  }
+
+  if(order_rows){
+    // rows with the same pattern are contiguous; within a pattern, rows with
+    // the same values on the definition variables are contiguous. The sort is
+    // stable so that rows that are identical in both keep their order.
+    result.order.resize(n_rows);
+    std::iota(result.order.begin(), result.order.end(), 0);
+    std::stable_sort(result.order.begin(), result.order.end(),
+                     [&](const std::size_t a, const std::size_t b){
+                       if(result.row_pattern[a] != result.row_pattern[b])
+                         return(result.row_pattern[a] < result.row_pattern[b]);
+                       for(const std::vector<double>& values: definition_values){
+                         const int comparison = compare_values(values[a], values[b]);
+                         if(comparison != 0)
+                           return(comparison < 0);
+                       }
+                       return(false);
+                     });
+  }
+
+  return(result);
+}
+
+static SEXP find_column(const Rcpp::List& data,
+                        const Rcpp::CharacterVector& data_names,
+                        const std::string& name){
+  for(R_xlen_t i = 0; i < data_names.size(); i++){
+    if(name.compare(CHAR(STRING_ELT(data_names, i))) == 0)
+      return(VECTOR_ELT(data, i));
+  }
+  Rcpp::stop("Could not find the variable " + name + " in the data.");
+}
+
+//' missingness_patterns_rcpp
+//'
+//' finds the missingness patterns of the manifest variables in a data set. Optionally,
+//' computes an order of the rows in which rows with the same missingness pattern
+//' and the same values on the definition variables are contiguous. OpenMx evaluates
+//' the full information maximum likelihood row by row and can reuse the
+//' expected covariances and means of the previous row if the pattern and the
+//' definition variables did not change.
+//' @param data data.frame with the raw data
+//' @param manifests names of the manifest variables
+//' @param definition_variables names of the definition variables (without the data. prefix)
+//' @param order_rows should the order of the rows be computed?
+//' @return list with the missingness patterns (logical matrix with one row per pattern and
+//' one column per manifest variable; TRUE indicates missing values), the number of
+//' rows with each pattern (counts), the pattern of each row (row_pattern), and the order of the
+//' rows (order; NULL if order_rows is FALSE). All indices start at 1.
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::List missingness_patterns_rcpp(Rcpp::List data,
+                                     const std::vector<std::string>& manifests,
+                                     const std::vector<std::string>& definition_variables,
+                                     bool order_rows = false){
+
+  const Rcpp::CharacterVector data_names(data.names());
+  const std::size_t n_rows = data.size() == 0 ? 0 : Rf_xlength(VECTOR_ELT(data, 0));
+  const std::size_t n_words = manifests.size() / 64 + 1;
+
+  std::vector<std::uint64_t> row_words(n_rows * n_words, 0);
+  for(std::size_t m = 0; m < manifests.size(); m++){
+    SEXP column = find_column(data, data_names, manifests[m]);
+    const std::uint64_t bit = std::uint64_t(1) << (m % 64);
+    std::uint64_t* words = row_words.data() + m / 64;
+
+    switch(TYPEOF(column)){
+    case REALSXP:{
+      const double* values = REAL(column);
+      for(std::size_t row = 0; row < n_rows; row++){
+        if(std::isnan(values[row]))
+          words[row * n_words] |= bit;
+      }
+      break;
+    }
+    case INTSXP:
+    case LGLSXP:{
+      // factors are integer vectors
+      const int* values = TYPEOF(column) == INTSXP ? INTEGER(column) : LOGICAL(column);
+      for(std::size_t row = 0; row < n_rows; row++){
+        if(values[row] == NA_INTEGER)
+          words[row * n_words] |= bit;
+      }
+      break;
+    }
+    case STRSXP:
+      for(std::size_t row = 0; row < n_rows; row++){
+        if(STRING_ELT(column, row) == NA_STRING)
+          words[row * n_words] |= bit;
+      }
+      break;
+    default:
+      Rcpp::stop("The variable " + manifests[m] + " has an unsupported type.");
+    }
+  }
+
+  std::vector<std::vector<double>> definition_values;
+  if(order_rows){
+    for(const std::string& definition_variable: definition_variables){
+      SEXP column = find_column(data, data_names, definition_variable);
+      if((TYPEOF(column) != REALSXP) && (TYPEOF(column) != INTSXP) && (TYPEOF(column) != LGLSXP))
+        Rcpp::stop("The definition variable " + definition_variable + " must be numeric.");
+      definition_values.push_back(Rcpp::as<std::vector<double>>(column));
+    }
+  }
+
+  missingness_result result = find_missingness_patterns(row_words, n_words, n_rows,
+                                                        definition_values, order_rows);
+
+  const std::size_t n_patterns = result.counts.size();
+  Rcpp::LogicalMatrix patterns(n_patterns, manifests.size());
+  for(std::size_t p = 0; p < n_patterns; p++){
+    for(std::size_t m = 0; m < manifests.size(); m++)
+      patterns(p, m) = (result.patterns[p * n_words + m / 64] >> (m % 64)) & 1;
+  }
+  patterns.attr("dimnames") = Rcpp::List::create(R_NilValue, Rcpp::wrap(manifests));
+
+  Rcpp::IntegerVector counts(result.counts.begin(), result.counts.end());
+  Rcpp::IntegerVector row_pattern(n_rows);
+  for(std::size_t row = 0; row < n_rows; row++)
+    row_pattern[row] = result.row_pattern[row] + 1;
+
+  SEXP order = R_NilValue;
+  Rcpp::IntegerVector row_order;
+  if(order_rows){
+    row_order = Rcpp::IntegerVector(n_rows);
+    for(std::size_t row = 0; row < n_rows; row++)
+      row_order[row] = result.order[row] + 1;
+    order = row_order;
+  }
+
+  return(Rcpp::List::create(Rcpp::Named("patterns") = patterns,
+                            Rcpp::Named("counts") = counts,
+                            Rcpp::Named("row_pattern") = row_pattern,
+                            Rcpp::Named("order") = order));
+}
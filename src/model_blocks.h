@@ -0,0 +1,29 @@
+#ifndef MODEL_BLOCKS_H
+#define MODEL_BLOCKS_H
+#include <Rcpp.h>
+#include <string_view>
+
+// A named model in a syntax document. Models are introduced by a header line
+// such as ===model_name===. All offsets are in bytes.
+struct model_block{
+  std::string name;         // model name without = and white space
+  std::size_t header_start; // start of the header line
+  std::size_t syntax_start; // first byte after the header
+  std::size_t syntax_end;   // one past the last byte of the model
+};
+
+// returns all models in the syntax. If the syntax has no header, a single
+// unnamed block spanning the entire syntax is returned.
+std::vector<model_block> find_model_blocks(std::string_view syntax);
+
+// returns all groups of a multi-group model. Groups are introduced by a line
+// of the form group: group_name. If the syntax has no group header, a single
+// unnamed block spanning the entire syntax is returned.
+std::vector<model_block> find_group_blocks(std::string_view syntax);
+
+// returns all include lines of the form include: module_name. For each
+// include, header_start is the start and syntax_start the end of the line;
+// syntax_end equals syntax_start.
+std::vector<model_block> find_include_lines(std::string_view syntax);
+
+#endif
@@ -0,0 +1,373 @@
+#include <Rcpp.h>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <unordered_map>
+#include "model_handle.h"
+#include "r_conversion.h"
+#include <iterator>
+#include <memory>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Binary format of a parsed model (all integers in the byte order of the
+// machine that wrote the file):
+//
+// header:     char[8] "MXSEMPT", uint32 version, uint32 byte order mark,
+//             uint8 parse settings (one bit per setting)
+// symbols:    uint32 n, then n times uint32 length and the characters
+// model name: uint32 symbol
+// parameters: uint32 n, then n rows of uint32 lhs, uint8 op, uint32 rhs,
+//             uint32 modifier, uint32 lbound, uint32 ubound, uint8 free
+// lists:      user_defined, new_parameters, new_parameters_free, algebra lhs,
+//             algebra op, algebra rhs, manifests, latents; each as uint32 n
+//             followed by n uint32 symbols
+// checksum:   uint64 FNV-1a hash of all preceding bytes
+//
+// Every string is stored once in the symbol table; all other sections refer
+// to it by index.
+static constexpr char model_file_magic[8] = {'M', 'X', 'S', 'E', 'M', 'P', 'T', '\0'};
+static const std::uint32_t model_file_version = 1;
+static const std::uint32_t byte_order_mark = 0x01020304;
+static constexpr std::string_view parameter_ops[] = {"=~", "~~", "~"};
+
+static std::uint64_t fnv1a(const char* data, const std::size_t size){
+  std::uint64_t hash = 14695981039346656037ULL;
+  for(std::size_t i = 0; i < size; i++){
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 1099511628211ULL;
+  }
+  return(hash);
+}
+
+class model_file_writer{
+public:
+  template<class T>
+  void write(const T value){
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+  }
+
+  void write_bytes(std::string_view bytes){
+    buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+  }
+
+  std::uint32_t symbol(std::string_view str){
+    auto known = symbols.find(str);
+    if(known != symbols.end())
+      return(known->second);
+    const std::uint32_t index = static_cast<std::uint32_t>(symbol_list.size());
+    symbols.emplace(str, index);
+    symbol_list.push_back(str);
+    return(index);
+  }
+
+  void collect(const pt_column& column){
+    for(const pt_string& element: column)
+      symbol(element);
+  }
+
+  void write_symbols(){
+    write<std::uint32_t>(symbol_list.size());
+    for(std::string_view str: symbol_list){
+      write<std::uint32_t>(str.size());
+      write_bytes(str);
+    }
+  }
+
+  void write_list(const pt_column& column){
+    write<std::uint32_t>(column.size());
+    for(const pt_string& element: column)
+      write<std::uint32_t>(symbol(element));
+  }
+
+  std::vector<char> buffer;
+
+private:
+  std::unordered_map<std::string_view, std::uint32_t> symbols;
+  std::vector<std::string_view> symbol_list;
+};
+
+// The file is mapped into memory and read directly from the mapping. On
+// Windows, the file is read into a buffer instead.
+class mapped_file{
+public:
+  explicit mapped_file(const std::string& file){
+#ifdef _WIN32
+    std::ifstream stream(file, std::ios::binary);
+    if(!stream)
+      Rcpp::stop("Could not open " + file + ".");
+    buffer.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    data = buffer.data();
+    size = buffer.size();
+#else
+    const int descriptor = open(file.c_str(), O_RDONLY);
+    if(descriptor < 0)
+      Rcpp::stop("Could not open " + file + ".");
+    struct stat file_stat;
+    if(fstat(descriptor, &file_stat) != 0){
+      close(descriptor);
+      Rcpp::stop("Could not read " + file + ".");
+    }
+    size = static_cast<std::size_t>(file_stat.st_size);
+    if(size != 0){
+      void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+      if(mapping == MAP_FAILED){
+        close(descriptor);
+        Rcpp::stop("Could not map " + file + " into memory.");
+      }
+      data = static_cast<const char*>(mapping);
+    }
+    // the mapping stays valid after the file is closed
+    close(descriptor);
+#endif
+  }
+
+  ~mapped_file(){
+#ifndef _WIN32
+    if(data != nullptr)
+      munmap(const_cast<char*>(data), size);
+#endif
+  }
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  const char* data = nullptr;
+  std::size_t size = 0;
+
+private:
+#ifdef _WIN32
+  std::vector<char> buffer;
+#endif
+};
+
+class model_file_reader{
+public:
+  model_file_reader(const char* data, const std::size_t size):
+  data(data), size(size){}
+
+  template<class T>
+  T read(){
+    T value;
+    std::memcpy(&value, read_bytes(sizeof(T)).data(), sizeof(T));
+    return(value);
+  }
+
+  std::string_view read_bytes(const std::size_t n){
+    if(n > size - position)
+      Rcpp::stop("The model file is truncated or corrupted.");
+    std::string_view bytes(data + position, n);
+    position += n;
+    return(bytes);
+  }
+
+  void read_symbols(){
+    const std::uint32_t n_symbols = read<std::uint32_t>();
+    symbols.reserve(n_symbols);
+    for(std::uint32_t i = 0; i < n_symbols; i++){
+      const std::uint32_t length = read<std::uint32_t>();
+      symbols.push_back(read_bytes(length));
+    }
+  }
+
+  std::string_view symbol(){
+    const std::uint32_t index = read<std::uint32_t>();
+    if(index >= symbols.size())
+      Rcpp::stop("The model file is truncated or corrupted.");
+    return(symbols[index]);
+  }
+
+  void read_list(pt_column& column){
+    const std::uint32_t n = read<std::uint32_t>();
+    column.reserve(n);
+    for(std::uint32_t i = 0; i < n; i++)
+      column.emplace_back(symbol());
+  }
+
+  std::size_t position = 0;
+
+private:
+  const char* data;
+  std::size_t size;
+  std::vector<std::string_view> symbols;
+};
+
+//' save_model_handle
+//'
+//' saves a parsed model in a binary file. The file can be loaded with
+//' load_model_file without parsing the syntax again.
+//' @param handle model handle created with parameter_table_rcpp(..., return_handle = TRUE)
+//' @param file path to the file
+//' @param model_name name of the model
+//' @return nothing
+//' @keywords internal
+// [[Rcpp::export]]
+void save_model_handle(SEXP handle,
+                       const std::string& file,
+                       const std::string& model_name){
+  Rcpp::XPtr<model_handle> model = get_model_handle(handle);
+  const parameter_table& pt = model->pt;
+
+  model_file_writer writer;
+
+  writer.write_bytes(std::string_view(model_file_magic, sizeof(model_file_magic)));
+  writer.write<std::uint32_t>(model_file_version);
+  writer.write<std::uint32_t>(byte_order_mark);
+  const parse_settings& settings = model->settings;
+  writer.write<std::uint8_t>(settings.add_intercept |
+                             settings.add_variance << 1 |
+                             settings.add_exogenous_latent_covariances << 2 |
+                             settings.add_exogenous_manifest_covariances << 3 |
+                             settings.scale_latent_variance << 4 |
+                             settings.scale_loading << 5);
+
+  // the symbol table must be complete before the rows can be written
+  writer.symbol(model_name);
+  for(const pt_column* column: {&pt.lhs, &pt.rhs, &pt.modifier, &pt.lbound, &pt.ubound,
+      &pt.user_defined, &pt.alg.new_parameters, &pt.alg.new_parameters_free,
+      &pt.alg.lhs, &pt.alg.op, &pt.alg.rhs, &pt.vars.manifests, &pt.vars.latents})
+    writer.collect(*column);
+  writer.write_symbols();
+
+  writer.write<std::uint32_t>(writer.symbol(model_name));
+
+  writer.write<std::uint32_t>(pt.lhs.size());
+  for(std::size_t i = 0; i < pt.lhs.size(); i++){
+    std::uint8_t op = 0;
+    while(op < std::size(parameter_ops) && pt.op.at(i) != parameter_ops[op])
+      op++;
+    if(op == std::size(parameter_ops))
+      Rcpp::stop("Unknown operator " + std::string(pt.op.at(i)) + " in the parameter table.");
+    if(pt.free.at(i) != "TRUE" && pt.free.at(i) != "FALSE")
+      Rcpp::stop("free must be TRUE or FALSE.");
+
+    writer.write<std::uint32_t>(writer.symbol(pt.lhs.at(i)));
+    writer.write<std::uint8_t>(op);
+    writer.write<std::uint32_t>(writer.symbol(pt.rhs.at(i)));
+    writer.write<std::uint32_t>(writer.symbol(pt.modifier.at(i)));
+    writer.write<std::uint32_t>(writer.symbol(pt.lbound.at(i)));
+    writer.write<std::uint32_t>(writer.symbol(pt.ubound.at(i)));
+    writer.write<std::uint8_t>(pt.free.at(i) == "TRUE");
+  }
+
+  for(const pt_column* column: {&pt.user_defined, &pt.alg.new_parameters, &pt.alg.new_parameters_free,
+      &pt.alg.lhs, &pt.alg.op, &pt.alg.rhs, &pt.vars.manifests, &pt.vars.latents})
+    writer.write_list(*column);
+
+  writer.write<std::uint64_t>(fnv1a(writer.buffer.data(), writer.buffer.size()));
+
+  std::ofstream stream(file, std::ios::binary | std::ios::trunc);
+  if(!stream)
+    Rcpp::stop("Could not open " + file + " for writing.");
+  stream.write(writer.buffer.data(), writer.buffer.size());
+  if(!stream)
+    Rcpp::stop("Could not write to " + file + ".");
+}
+
+// reads the model saved in file; the name of the model is written to model_name
+static std::unique_ptr<model_handle> read_model_file(const std::string& file,
+                                                     std::string& model_name){
+  mapped_file mapping(file);
+
+  if(mapping.size < sizeof(model_file_magic) + sizeof(std::uint64_t) ||
+     std::memcmp(mapping.data, model_file_magic, sizeof(model_file_magic)) != 0)
+    Rcpp::stop(file + " is not a model file created by mxsem.");
+
+  // the checksum covers everything but itself
+  const std::size_t content_size = mapping.size - sizeof(std::uint64_t);
+  std::uint64_t checksum;
+  std::memcpy(&checksum, mapping.data + content_size, sizeof(checksum));
+  if(checksum != fnv1a(mapping.data, content_size))
+    Rcpp::stop("The model file is truncated or corrupted.");
+
+  model_file_reader reader(mapping.data, content_size);
+  reader.read_bytes(sizeof(model_file_magic));
+  const std::uint32_t version = reader.read<std::uint32_t>();
+  if(version != model_file_version)
+    Rcpp::stop("The model file was created with a different version of mxsem (file format " +
+      std::to_string(version) + "). Please save the model again.");
+  if(reader.read<std::uint32_t>() != byte_order_mark)
+    Rcpp::stop("The model file was created on a machine with a different byte order.");
+  const std::uint8_t settings_bits = reader.read<std::uint8_t>();
+
+  reader.read_symbols();
+  model_name = reader.symbol();
+
+  // the strings are copied from the mapping into the arena of the handle
+  std::unique_ptr<model_handle> model = std::make_unique<model_handle>(mapping.size + 1024);
+  model->settings = {(settings_bits & 1) != 0,
+                     (settings_bits & 1 << 1) != 0,
+                     (settings_bits & 1 << 2) != 0,
+                     (settings_bits & 1 << 3) != 0,
+                     (settings_bits & 1 << 4) != 0,
+                     (settings_bits & 1 << 5) != 0};
+  parameter_table& pt = model->pt;
+
+  const std::uint32_t n_rows = reader.read<std::uint32_t>();
+  for(std::uint32_t i = 0; i < n_rows; i++){
+    pt.add_line();
+    pt.lhs.back() = reader.symbol();
+    const std::uint8_t op = reader.read<std::uint8_t>();
+    if(op >= std::size(parameter_ops))
+      Rcpp::stop("The model file is truncated or corrupted.");
+    pt.op.back() = parameter_ops[op];
+    pt.rhs.back() = reader.symbol();
+    pt.modifier.back() = reader.symbol();
+    pt.lbound.back() = reader.symbol();
+    pt.ubound.back() = reader.symbol();
+    pt.free.back() = reader.read<std::uint8_t>() ? "TRUE" : "FALSE";
+  }
+
+  for(pt_column* column: {&pt.user_defined, &pt.alg.new_parameters, &pt.alg.new_parameters_free,
+      &pt.alg.lhs, &pt.alg.op, &pt.alg.rhs, &pt.vars.manifests, &pt.vars.latents})
+    reader.read_list(*column);
+
+  if(reader.position != content_size)
+    Rcpp::stop("The model file is truncated or corrupted.");
+
+  return(model);
+}
+
+//' load_model_file
+//'
+//' loads a model saved with save_model_handle.
+//' @param file path to the file
+//' @param return_handle if TRUE, the parameter table is returned as model handle
+//' (see parameter_table_rcpp)
+//' @return list with the model name, the settings used when parsing the model, and
+//' the parameter table (see parameter_table_rcpp)
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::List load_model_file(const std::string& file,
+                           bool return_handle = false){
+  std::string model_name;
+  Rcpp::XPtr<model_handle> model(read_model_file(file, model_name).release(), true);
+
+  const parse_settings& settings = model->settings;
+  Rcpp::LogicalVector r_settings = Rcpp::LogicalVector::create(
+    Rcpp::Named("add_intercept") = settings.add_intercept,
+    Rcpp::Named("add_variance") = settings.add_variance,
+    Rcpp::Named("add_exogenous_latent_covariances") = settings.add_exogenous_latent_covariances,
+    Rcpp::Named("add_exogenous_manifest_covariances") = settings.add_exogenous_manifest_covariances,
+    Rcpp::Named("scale_latent_variance") = settings.scale_latent_variance,
+    Rcpp::Named("scale_loading") = settings.scale_loading);
+
+  Rcpp::RObject table;
+  if(return_handle){
+    model.attr("class") = "mxsem_model_handle";
+    table = model;
+  }else{
+    table = parameter_table_to_r(model->pt);
+  }
+
+  return(Rcpp::List::create(Rcpp::Named("model_name") = model_name,
+                            Rcpp::Named("settings") = r_settings,
+                            Rcpp::Named("parameter_table") = table));
+}
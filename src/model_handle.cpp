@@ -0,0 +1,67 @@
+#include <Rcpp.h>
+#include "model_handle.h"
+#include "r_conversion.h"
+
+Rcpp::XPtr<model_handle> get_model_handle(SEXP handle){
+  // any other external pointer would be cast to a model handle
+  if((TYPEOF(handle) != EXTPTRSXP) || !Rf_inherits(handle, "mxsem_model_handle"))
+    Rcpp::stop("Expected a model handle created with parameter_table_rcpp(..., return_handle = TRUE).");
+  if(R_ExternalPtrAddr(handle) == nullptr)
+    Rcpp::stop("The model handle is no longer valid. Handles cannot be saved and restored across R sessions; use mxsem_save_parsed instead.");
+  return(Rcpp::XPtr<model_handle>(handle));
+}
+
+//' handle_parameter_table
+//'
+//' returns selected columns and rows of the parameter table stored in
+//' a model handle (see parameter_table_rcpp)
+//' @param handle model handle created with parameter_table_rcpp(..., return_handle = TRUE)
+//' @param columns names of the columns that should be returned. If NULL, all
+//' columns are returned
+//' @param rows indices of the rows that should be returned. If NULL, all rows
+//' are returned
+//' @return data.frame with the requested part of the parameter table
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::List handle_parameter_table(SEXP handle,
+                                  Rcpp::Nullable<Rcpp::CharacterVector> columns = R_NilValue,
+                                  Rcpp::Nullable<Rcpp::IntegerVector> rows = R_NilValue){
+
+  Rcpp::XPtr<model_handle> model = get_model_handle(handle);
+  const parameter_table& pt = model->pt;
+
+  std::vector<std::string> selected_columns = {"lhs", "op", "rhs", "modifier", "lbound", "ubound", "free"};
+  if(columns.isNotNull())
+    selected_columns = Rcpp::as<std::vector<std::string>>(columns.get());
+
+  std::vector<std::size_t> selected_rows;
+  if(rows.isNotNull()){
+    Rcpp::IntegerVector r_rows(rows.get());
+    selected_rows.reserve(r_rows.size());
+    for(R_xlen_t i = 0; i < r_rows.size(); i++){
+      if((r_rows[i] == NA_INTEGER) || (r_rows[i] < 1))
+        Rcpp::stop("rows must be positive integers.");
+      // R indices start at 1
+      selected_rows.push_back(r_rows[i] - 1);
+    }
+  }else{
+    selected_rows = all_rows(pt.lhs.size());
+  }
+
+  r_string_cache cache(pt.resource());
+  return(parameter_table_columns_to_r(pt, selected_columns, selected_rows, cache));
+}
+
+//' handle_to_list
+//'
+//' converts a model handle (see parameter_table_rcpp) to the list returned
+//' by parameter_table_rcpp(..., return_handle = FALSE)
+//' @param handle model handle created with parameter_table_rcpp(..., return_handle = TRUE)
+//' @return list with parameter table, user defined elements, algebras, variables,
+//' and new parameters
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::List handle_to_list(SEXP handle){
+  Rcpp::XPtr<model_handle> model = get_model_handle(handle);
+  return(parameter_table_to_r(model->pt));
+}
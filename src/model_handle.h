@@ -0,0 +1,33 @@
+#ifndef MODEL_HANDLE_H
+#define MODEL_HANDLE_H
+#include <Rcpp.h>
+#include "parameter_table.h"
+
+// settings used to create the parameter table of a model handle
+struct parse_settings{
+  bool add_intercept;
+  bool add_variance;
+  bool add_exogenous_latent_covariances;
+  bool add_exogenous_manifest_covariances;
+  bool scale_latent_variance;
+  bool scale_loading;
+};
+
+// A parsed model together with the arena its strings are allocated from.
+// The model is handed to R as an external pointer; the parameter table is
+// only converted to R objects when (and as far as) it is requested.
+// arena must be declared before pt: pt has to be destroyed first.
+class model_handle{
+public:
+  explicit model_handle(std::size_t initial_size):
+  arena(initial_size),
+  pt(&arena){}
+
+  std::pmr::monotonic_buffer_resource arena;
+  parameter_table pt;
+  parse_settings settings{};
+};
+
+Rcpp::XPtr<model_handle> get_model_handle(SEXP handle);
+
+#endif
@@ -0,0 +1,179 @@
+#include <Rcpp.h>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "make_parameter_table.h"
+#include "model_blocks.h"
+#include "modules.h"
+
+namespace {
+// mxsem_multi parses models on separate threads; all access to the registered
+// and parsed modules is guarded by modules_mutex.
+std::mutex modules_mutex;
+std::unordered_map<std::string, std::string> registered_modules;
+// parsed modules by the key returned by module_key
+std::unordered_map<std::string, std::shared_ptr<const parsed_module>> parsed_modules;
+// modules that are currently parsed on this thread
+thread_local std::vector<std::string> include_stack;
+// syntaxes and keys of the modules used in the current top-level call of
+// find_module. Nested includes reuse them instead of reading the files again.
+thread_local std::unordered_map<std::string, std::string> lookup_syntaxes;
+thread_local std::unordered_map<std::string, std::string> lookup_keys;
+}
+
+// returns the syntax of a registered module or the content of the file name
+static const std::string& module_syntax(const std::string& name){
+  auto known = lookup_syntaxes.find(name);
+  if(known != lookup_syntaxes.end())
+    return(known->second);
+  {
+    std::lock_guard<std::mutex> lock(modules_mutex);
+    auto module = registered_modules.find(name);
+    if(module != registered_modules.end())
+      return(lookup_syntaxes.emplace(name, module->second).first->second);
+  }
+  std::ifstream file(name, std::ios::binary);
+  if(!file)
+    parse_stop("Could not find the module " + name +
+      ". Modules must be registered with mxsem_register_module or be a file with the syntax of the module.");
+  return(lookup_syntaxes.emplace(name,
+                                 std::string(std::istreambuf_iterator<char>(file),
+                                             std::istreambuf_iterator<char>())).first->second);
+}
+
+// the syntax of a module followed by the keys of all modules it includes
+// (each prefixed with its length): changing an included module also changes
+// the key of all modules that include it.
+static const std::string& module_key(const std::string& name,
+                                     std::vector<std::string>& stack){
+  auto known = lookup_keys.find(name);
+  if(known != lookup_keys.end())
+    return(known->second);
+
+  if(std::find(stack.begin(), stack.end(), name) != stack.end()){
+    std::string path;
+    for(const std::string& module: stack)
+      path += module + " -> ";
+    parse_stop("The module " + name + " includes itself (" + path + name + ").");
+  }
+
+  stack.push_back(name);
+  const std::string& syntax = module_syntax(name);
+  std::string key = std::to_string(syntax.size()) + ':' + syntax;
+  for(const model_block& include: find_include_lines(syntax)){
+    const std::string& included = module_key(include.name, stack);
+    key += std::to_string(included.size()) + ':';
+    key += included;
+  }
+  stack.pop_back();
+  return(lookup_keys.emplace(name, std::move(key)).first->second);
+}
+
+// keeps track of the modules that are parsed on this thread
+class include_guard{
+public:
+  explicit include_guard(const std::string& name){
+    include_stack.push_back(name);
+  }
+  ~include_guard(){
+    include_stack.pop_back();
+  }
+};
+
+// forgets the syntaxes read in a top-level call of find_module once it returns
+class lookup_guard{
+public:
+  lookup_guard(): top_level(include_stack.empty()){}
+  ~lookup_guard(){
+    if(top_level){
+      lookup_syntaxes.clear();
+      lookup_keys.clear();
+    }
+  }
+private:
+  const bool top_level;
+};
+
+std::shared_ptr<const parsed_module> find_module(const std::string& name){
+  lookup_guard lookup;
+  std::vector<std::string> stack = include_stack;
+  const std::string& key = module_key(name, stack);
+  {
+    std::lock_guard<std::mutex> lock(modules_mutex);
+    auto module = parsed_modules.find(key);
+    if(module != parsed_modules.end())
+      return(module->second);
+  }
+
+  // the module is parsed without holding the lock; if two threads parse the
+  // same module, the first one is kept.
+  const std::string& syntax = module_syntax(name);
+  auto module = std::make_shared<parsed_module>(4 * syntax.size() + 1024);
+  std::string error;
+  {
+    include_guard guard(name);
+    collect_diagnostics collect(module->diagnostics);
+    try{
+      module->equations = parse_equations(syntax, module->pt);
+    }catch(const parse_error& e){
+      error = e.what();
+    }
+  }
+  if(!error.empty())
+    parse_stop("Error in module " + name + ": " + error);
+
+  std::lock_guard<std::mutex> lock(modules_mutex);
+  return(parsed_modules.emplace(key, module).first->second);
+}
+
+//' register_module_rcpp
+//'
+//' registers a module for the current session. Models include the module with
+//' a line of the form include: name.
+//' @param name name of the module
+//' @param syntax lavaan like syntax of the module
+//' @return nothing
+//' @keywords internal
+// [[Rcpp::export]]
+void register_module_rcpp(const std::string& name,
+                          const std::string& syntax){
+  if(name.empty() ||
+     (name.find_first_of(" \t\r\n#") != std::string::npos))
+    Rcpp::stop("Invalid module name: " + name + ". Module names must not be empty or contain white space or #.");
+
+  std::lock_guard<std::mutex> lock(modules_mutex);
+  registered_modules[name] = syntax;
+}
+
+//' registered_modules_rcpp
+//'
+//' returns the names of all modules registered in the current session.
+//' @return sorted vector with module names
+//' @keywords internal
+// [[Rcpp::export]]
+std::vector<std::string> registered_modules_rcpp(){
+  std::vector<std::string> names;
+  {
+    std::lock_guard<std::mutex> lock(modules_mutex);
+    for(const auto& module: registered_modules)
+      names.push_back(module.first);
+  }
+  std::sort(names.begin(), names.end());
+  return(names);
+}
+
+//' clear_modules_rcpp
+//'
+//' removes all registered modules and all cached parses of modules.
+//' @return nothing
+//' @keywords internal
+// [[Rcpp::export]]
+void clear_modules_rcpp(){
+  std::lock_guard<std::mutex> lock(modules_mutex);
+  registered_modules.clear();
+  parsed_modules.clear();
+}
@@ -0,0 +1,31 @@
+#ifndef MODULES_H
+#define MODULES_H
+#include <Rcpp.h>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include "diagnostics.h"
+#include "parameter_table.h"
+
+// Syntaxes can include modules with a line of the form include: module_name.
+// A module is either registered in the session (see register_module_rcpp) or
+// a file with the path module_name. The first stage of the parser (see
+// parse_equations) runs only once per module: the parsed module is cached by
+// its syntax (and the syntax of all modules it includes) and its rows and
+// equations are copied into each model that includes the module.
+struct parsed_module{
+  explicit parsed_module(std::size_t initial_size):
+    arena(initial_size), pt(&arena), equations(&arena){}
+
+  std::pmr::monotonic_buffer_resource arena;
+  parameter_table pt;
+  pt_column equations;
+  // warnings and messages of the parse; reported each time the module is used
+  parse_diagnostics diagnostics;
+};
+
+// returns the parsed module. Errors in the module are raised with parse_stop.
+// Safe to call from multiple threads.
+std::shared_ptr<const parsed_module> find_module(const std::string& name);
+
+#endif
@@ -0,0 +1,194 @@
+#include <Rcpp.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "r_conversion.h"
+
+// Model searches fit many models to the same data. Without intercepts, each
+// model only needs the observed covariances of its manifest variables. These
+// are cached for the session: each column is identified by its name and a hash
+// of its values, so a model with a subset of the variables of a cached matrix
+// gets its covariances by sub-setting this matrix instead of recomputing them.
+// Only data without missing values is cached, because the complete rows of a
+// subset of the variables can differ from those of the full set.
+
+namespace {
+struct cached_moments{
+  std::vector<std::string> names;
+  std::vector<std::uint64_t> hashes;
+  std::vector<double> means;
+  // column major
+  std::vector<double> covariance;
+  std::size_t n_observations;
+};
+
+std::mutex moment_cache_mutex;
+// most recently used first
+std::deque<cached_moments> moment_cache;
+constexpr std::size_t max_cached_moments = 16;
+}
+
+// hashes the bit patterns of the values eight bytes at a time
+static std::uint64_t hash_column(const std::string& name,
+                                 const std::vector<double>& values){
+  std::uint64_t hash = 14695981039346656037ULL;
+  auto add = [&hash](std::uint64_t word){
+    hash ^= word;
+    hash *= 1099511628211ULL;
+    hash ^= hash >> 32;
+  };
+  for(const char c: name)
+    add(static_cast<unsigned char>(c));
+  add(values.size());
+  for(const double value: values){
+    std::uint64_t word;
+    std::memcpy(&word, &value, sizeof(word));
+    add(word);
+  }
+  return(hash);
+}
+
+// positions of the requested columns in a cached entry; empty if the entry
+// does not contain all of them
+static std::vector<std::size_t> find_columns(const cached_moments& entry,
+                                             const std::vector<std::string>& names,
+                                             const std::vector<std::uint64_t>& hashes){
+  std::vector<std::size_t> positions;
+  for(std::size_t c = 0; c < names.size(); c++){
+    std::size_t k = 0;
+    while((k < entry.names.size()) &&
+          ((entry.hashes[k] != hashes[c]) || (entry.names[k] != names[c])))
+      k++;
+    if(k == entry.names.size())
+      return(std::vector<std::size_t>());
+    positions.push_back(k);
+  }
+  return(positions);
+}
+
+static cached_moments compute_moments(const std::vector<std::string>& names,
+                                      const std::vector<std::uint64_t>& hashes,
+                                      const std::vector<std::vector<double>>& columns){
+  const std::size_t n_columns = columns.size();
+  const std::size_t n_rows = columns.at(0).size();
+  cached_moments moments{names, hashes, std::vector<double>(n_columns, 0.0),
+                         std::vector<double>(n_columns * n_columns, 0.0), n_rows};
+
+  // two passes: means first, then the cross products of the deviations
+  for(std::size_t c = 0; c < n_columns; c++){
+    for(const double value: columns[c])
+      moments.means[c] += value;
+    moments.means[c] /= static_cast<double>(n_rows);
+  }
+  std::vector<double> deviations(n_columns);
+  for(std::size_t r = 0; r < n_rows; r++){
+    for(std::size_t c = 0; c < n_columns; c++)
+      deviations[c] = columns[c][r] - moments.means[c];
+    for(std::size_t c = 0; c < n_columns; c++){
+      for(std::size_t k = c; k < n_columns; k++)
+        moments.covariance[k * n_columns + c] += deviations[c] * deviations[k];
+    }
+  }
+  for(std::size_t c = 0; c < n_columns; c++){
+    for(std::size_t k = c; k < n_columns; k++){
+      const double value = moments.covariance[k * n_columns + c] / static_cast<double>(n_rows - 1);
+      moments.covariance[k * n_columns + c] = value;
+      moments.covariance[c * n_columns + k] = value;
+    }
+  }
+  return(moments);
+}
+
+//' observed_moments_rcpp
+//'
+//' returns the observed covariances and means of columns of a data set. The moments
+//' are cached for the session and the moments of a subset of the columns of a cached
+//' entry are taken from this entry. Columns are identified by their name and a hash
+//' of their values.
+//' @param data data.frame
+//' @param columns names of the columns
+//' @return list with the covariance matrix (covariance), the means (means), the number
+//' of rows (n_observations), and whether the moments were taken from the cache (cached).
+//' NULL if one of the columns has missing values.
+//' @keywords internal
+// [[Rcpp::export]]
+SEXP observed_moments_rcpp(Rcpp::List data,
+                           const std::vector<std::string>& columns){
+  const std::size_t n_columns = columns.size();
+  if(n_columns == 0)
+    Rcpp::stop("No columns were selected.");
+
+  std::vector<std::vector<double>> values;
+  std::vector<std::uint64_t> hashes;
+  for(const std::string& column: columns){
+    values.push_back(read_numeric_column(data, column));
+    for(const double value: values.back()){
+      if(std::isnan(value))
+        return(R_NilValue);
+    }
+    hashes.push_back(hash_column(column, values.back()));
+  }
+  if(values.at(0).size() < 2)
+    Rcpp::stop("The data must have at least two rows.");
+
+  cached_moments moments;
+  std::vector<std::size_t> positions;
+  bool is_cached = false;
+  {
+    std::lock_guard<std::mutex> lock(moment_cache_mutex);
+    for(auto entry = moment_cache.begin(); entry != moment_cache.end(); entry++){
+      positions = find_columns(*entry, columns, hashes);
+      if(positions.empty())
+        continue;
+      is_cached = true;
+      moments = *entry;
+      if(entry != moment_cache.begin()){
+        moment_cache.erase(entry);
+        moment_cache.push_front(moments);
+      }
+      break;
+    }
+  }
+
+  if(!is_cached){
+    moments = compute_moments(columns, hashes, values);
+    for(std::size_t c = 0; c < n_columns; c++)
+      positions.push_back(c);
+    std::lock_guard<std::mutex> lock(moment_cache_mutex);
+    moment_cache.push_front(moments);
+    if(moment_cache.size() > max_cached_moments)
+      moment_cache.pop_back();
+  }
+
+  const std::size_t n_cached = moments.names.size();
+  Rcpp::NumericMatrix covariance(n_columns, n_columns);
+  Rcpp::NumericVector means(n_columns);
+  for(std::size_t c = 0; c < n_columns; c++){
+    means[c] = moments.means[positions[c]];
+    for(std::size_t k = 0; k < n_columns; k++)
+      covariance(k, c) = moments.covariance[positions[c] * n_cached + positions[k]];
+  }
+  Rcpp::CharacterVector column_names(columns.begin(), columns.end());
+  covariance.attr("dimnames") = Rcpp::List::create(column_names, column_names);
+  means.attr("names") = column_names;
+
+  return(Rcpp::List::create(Rcpp::Named("covariance") = covariance,
+                            Rcpp::Named("means") = means,
+                            Rcpp::Named("n_observations") = static_cast<double>(moments.n_observations),
+                            Rcpp::Named("cached") = is_cached));
+}
+
+//' clear_moment_cache_rcpp
+//'
+//' removes all observed moments cached by observed_moments_rcpp.
+//' @return nothing
+//' @keywords internal
+// [[Rcpp::export]]
+void clear_moment_cache_rcpp(){
+  std::lock_guard<std::mutex> lock(moment_cache_mutex);
+  moment_cache.clear();
+}
@@ -0,0 +1,330 @@
+#include <Rcpp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include "algebra_parser.h"
+#include "r_conversion.h"
+
+struct algebra_expression{
+  std::string lhs;
+  int root;
+  bool is_constant;
+  double value;
+};
+
+static void make_number(algebra_node& node, const double value){
+  node.type = node_type::number;
+  node.text = format_number(value);
+  node.children.clear();
+}
+
+// Replaces all subtrees that only depend on numbers and constant algebras with
+// their value. Returns true if the node itself is now a number.
+static bool fold_constants(std::vector<algebra_node>& nodes,
+                           const int id,
+                           const std::unordered_map<std::string, double>& constants){
+  switch(nodes[id].type){
+  case node_type::number:
+    return(true);
+  case node_type::symbol:{
+    auto constant = constants.find(nodes[id].text);
+    if(constant == constants.end())
+      return(false);
+    make_number(nodes[id], constant->second);
+    return(true);
+  }
+  default:
+    break;
+  }
+
+  bool all_numbers = true;
+  const std::vector<int>& children = nodes[id].children;
+  for(int child: children)
+    all_numbers = fold_constants(nodes, child, constants) && all_numbers;
+  if(!all_numbers)
+    return(false);
+
+  std::vector<double> values;
+  for(int child: children)
+    values.push_back(std::strtod(nodes[child].text.c_str(), nullptr));
+
+  const algebra_node& node = nodes[id];
+  double value;
+  if(node.type == node_type::unary && node.text == "-"){
+    value = -values[0];
+  }else if(node.type == node_type::unary && node.text == "+"){
+    value = values[0];
+  }else if(node.type == node_type::binary && node.text == "+"){
+    value = values[0] + values[1];
+  }else if(node.type == node_type::binary && node.text == "-"){
+    value = values[0] - values[1];
+  }else if(node.type == node_type::binary && node.text == "*"){
+    value = values[0] * values[1];
+  }else if(node.type == node_type::binary && node.text == "/"){
+    value = values[0] / values[1];
+  }else if(node.type == node_type::binary && node.text == "^"){
+    value = std::pow(values[0], values[1]);
+  }else if(node.type == node_type::call && values.size() == 1 && node.text == "exp"){
+    value = std::exp(values[0]);
+  }else if(node.type == node_type::call && values.size() == 1 && node.text == "log"){
+    value = std::log(values[0]);
+  }else if(node.type == node_type::call && values.size() == 1 && node.text == "sqrt"){
+    value = std::sqrt(values[0]);
+  }else if(node.type == node_type::call && values.size() == 1 && node.text == "abs"){
+    value = std::abs(values[0]);
+  }else{
+    return(false);
+  }
+  // NaN and infinite values are left to OpenMx
+  if(!std::isfinite(value))
+    return(false);
+  make_number(nodes[id], value);
+  return(true);
+}
+
+static int count_nodes(const std::vector<algebra_node>& nodes, const int id){
+  int n = 1;
+  for(int child: nodes[id].children)
+    n += count_nodes(nodes, child);
+  return(n);
+}
+
+// Only subexpressions that actually compute something are worth sharing.
+static bool is_shareable(const std::vector<algebra_node>& nodes, const int id){
+  const algebra_node& node = nodes[id];
+  if(node.type == node_type::binary || node.type == node_type::call)
+    return(true);
+  return(node.type == node_type::unary &&
+         !nodes[node.children[0]].children.empty());
+}
+
+static void find_subexpressions(const std::vector<algebra_node>& nodes,
+                                const int id,
+                                std::unordered_map<std::string, std::vector<int>>& occurrences){
+  if(is_shareable(nodes, id))
+    occurrences[node_to_string(nodes, id)].push_back(id);
+  for(int child: nodes[id].children)
+    find_subexpressions(nodes, child, occurrences);
+}
+
+// Moves subexpressions that occur multiple times to separate algebras. The
+// largest repeated subexpression is replaced first.
+static void share_subexpressions(std::vector<algebra_node>& nodes,
+                                 std::vector<algebra_expression>& expressions,
+                                 std::unordered_set<std::string>& used_names){
+  int n_shared = 0;
+  while(true){
+    std::unordered_map<std::string, std::vector<int>> occurrences;
+    for(const algebra_expression& expression: expressions)
+      find_subexpressions(nodes, expression.root, occurrences);
+
+    const std::string* best = nullptr;
+    int best_size = 0;
+    for(const auto& occurrence: occurrences){
+      if(occurrence.second.size() < 2)
+        continue;
+      const int size = count_nodes(nodes, occurrence.second[0]);
+      // ties are broken by the expression itself to keep the result deterministic
+      if(size > best_size || (size == best_size && occurrence.first < *best)){
+        best = &occurrence.first;
+        best_size = size;
+      }
+    }
+    if(best == nullptr)
+      return;
+
+    // if an algebra consists of the subexpression only, the other
+    // occurrences can refer to this algebra directly
+    const std::vector<int>& repeated = occurrences[*best];
+    std::string name;
+    int defining_root = -1;
+    for(const algebra_expression& expression: expressions){
+      if(is_valid_symbol(expression.lhs) &&
+         std::find(repeated.begin(), repeated.end(), expression.root) != repeated.end()){
+        name = expression.lhs;
+        defining_root = expression.root;
+        break;
+      }
+    }
+    if(name.empty()){
+      do{
+        name = "mxsem_cse_" + std::to_string(++n_shared);
+      }while(used_names.count(name) != 0);
+      used_names.insert(name);
+      // the new algebra gets a copy of the subexpression; all occurrences
+      // point to it
+      algebra_node shared = nodes[repeated[0]];
+      nodes.push_back(std::move(shared));
+      defining_root = static_cast<int>(nodes.size()) - 1;
+      expressions.insert(expressions.begin(), {name, defining_root, false, 0.0});
+    }
+
+    for(int id: repeated){
+      if(id == defining_root)
+        continue;
+      nodes[id].type = node_type::symbol;
+      nodes[id].text = name;
+      nodes[id].children.clear();
+    }
+  }
+}
+
+struct optimized_algebras{
+  std::vector<std::string> lhs, rhs;
+  // algebras that were replaced by their value
+  std::vector<std::string> constant_labels;
+  std::vector<double> constant_values;
+  // algebras that no longer exist
+  std::vector<std::string> removed;
+};
+
+static optimized_algebras optimize_algebras(const std::vector<std::string>& lhs,
+                                            const std::vector<std::string>& rhs,
+                                            const std::vector<std::string>& referenced,
+                                            const std::vector<std::string>& user_defined){
+  std::vector<algebra_node> nodes;
+  std::vector<algebra_expression> expressions;
+  algebra_parser parser(nodes);
+  bool all_parsed = true;
+  for(std::size_t i = 0; i < lhs.size(); i++){
+    int root = parser.parse(rhs[i]);
+    if(root < 0){
+      all_parsed = false;
+      break;
+    }
+    expressions.push_back({lhs[i], root, false, 0.0});
+  }
+
+  std::unordered_set<std::string> user_referenced;
+  for(const std::string& code: user_defined){
+    for(std::string_view symbol: algebra_parser::symbols(code))
+      user_referenced.emplace(symbol);
+  }
+
+  optimized_algebras result;
+
+  if(!all_parsed){
+    // algebras we cannot parse are passed on to OpenMx unchanged
+    result.lhs = lhs;
+    result.rhs = rhs;
+  }else{
+    // constant folding; repeated until no further algebra becomes constant
+    // because algebras can depend on other algebras
+    std::unordered_map<std::string, double> constants;
+    bool changed = true;
+    while(changed){
+      changed = false;
+      for(algebra_expression& expression: expressions){
+        if(expression.is_constant)
+          continue;
+        if(fold_constants(nodes, expression.root, constants)){
+          expression.is_constant = true;
+          expression.value = std::strtod(nodes[expression.root].text.c_str(), nullptr);
+          constants[expression.lhs] = expression.value;
+          changed = true;
+        }
+      }
+    }
+
+    // dead algebra elimination: starting from the referenced algebras, we
+    // follow all algebras used in other algebras
+    std::unordered_set<std::string> live(referenced.begin(), referenced.end());
+    live.insert(user_referenced.begin(), user_referenced.end());
+    changed = true;
+    while(changed){
+      changed = false;
+      for(const algebra_expression& expression: expressions){
+        if(live.count(expression.lhs) == 0)
+          continue;
+        std::unordered_set<std::string> symbols;
+        collect_symbols(nodes, expression.root, symbols);
+        for(const std::string& symbol: symbols){
+          if(live.insert(symbol).second)
+            changed = true;
+        }
+      }
+    }
+
+    std::vector<algebra_expression> kept;
+    std::unordered_set<std::string> used_names;
+    for(const algebra_expression& expression: expressions){
+      used_names.insert(expression.lhs);
+      collect_symbols(nodes, expression.root, used_names);
+      if(expression.is_constant){
+        result.constant_labels.push_back(expression.lhs);
+        result.constant_values.push_back(expression.value);
+        // constant algebras are replaced by their value unless the user
+        // refers to them in user defined elements
+        if(user_referenced.count(expression.lhs) == 0)
+          continue;
+      }
+      if(live.count(expression.lhs) != 0)
+        kept.push_back(expression);
+    }
+    used_names.insert(referenced.begin(), referenced.end());
+    used_names.insert(user_referenced.begin(), user_referenced.end());
+
+    share_subexpressions(nodes, kept, used_names);
+
+    for(const algebra_expression& expression: kept){
+      result.lhs.push_back(expression.lhs);
+      result.rhs.push_back(node_to_string(nodes, expression.root));
+    }
+  }
+
+  std::unordered_set<std::string> kept_names(result.lhs.begin(), result.lhs.end());
+  for(const std::string& name: lhs){
+    if(kept_names.count(name) == 0)
+      result.removed.push_back(name);
+  }
+  return(result);
+}
+
+//' optimize_algebras_rcpp
+//'
+//' simplifies the algebras of a model before the model is built. Algebras
+//' that depend neither on free parameters nor on definition variables are
+//' replaced with their value, algebras that are not referenced anywhere are
+//' removed, and subexpressions used in multiple algebras are moved to
+//' separate algebras.
+//' @param lhs names of the algebras
+//' @param rhs the algebras
+//' @param referenced labels used in the model (e.g., labels of the paths). Algebras
+//' with these names are kept.
+//' @param user_defined user defined elements. Algebras referred to in these elements
+//' are kept unchanged
+//' @return list with the optimized algebras (data.frame with lhs, op, and rhs),
+//' the values of constant algebras (data.frame with label and value), and the names
+//' of all algebras that were removed.
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::List optimize_algebras_rcpp(const std::vector<std::string>& lhs,
+                                  const std::vector<std::string>& rhs,
+                                  const std::vector<std::string>& referenced,
+                                  const std::vector<std::string>& user_defined){
+  if(lhs.size() != rhs.size())
+    Rcpp::stop("lhs and rhs of the algebras must be of the same length.");
+
+  optimized_algebras result = optimize_algebras(lhs, rhs, referenced, user_defined);
+
+  const R_xlen_t n_algebras = static_cast<R_xlen_t>(result.lhs.size());
+  Rcpp::List algebras = make_data_frame(
+    Rcpp::List::create(Rcpp::wrap(result.lhs),
+                       Rcpp::wrap(std::vector<std::string>(result.lhs.size(), ":=")),
+                       Rcpp::wrap(result.rhs)),
+    Rcpp::CharacterVector::create("lhs", "op", "rhs"),
+    n_algebras);
+  Rcpp::List constant_algebras = make_data_frame(
+    Rcpp::List::create(Rcpp::wrap(result.constant_labels),
+                       Rcpp::wrap(result.constant_values)),
+    Rcpp::CharacterVector::create("label", "value"),
+    static_cast<R_xlen_t>(result.constant_labels.size()));
+
+  return(Rcpp::List::create(Rcpp::Named("algebras") = algebras,
+                            Rcpp::Named("constants") = constant_algebras,
+                            Rcpp::Named("removed") = result.removed));
+}
@@ -0,0 +1,248 @@
+#include <Rcpp.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include "algebra_parser.h"
+#include "r_conversion.h"
+
+// functions that return a 1x1 matrix when called with 1x1 matrices
+static bool is_elementwise_function(std::string_view name){
+  static constexpr std::string_view elementwise[] = {
+    "exp", "log", "sqrt", "abs", "sin", "cos", "tan", "sinh", "cosh", "tanh"
+  };
+  return(std::find(std::begin(elementwise), std::end(elementwise), name) != std::end(elementwise));
+}
+
+class algebra_packer{
+public:
+  algebra_packer(const std::vector<algebra_node>& nodes,
+                 const std::unordered_map<std::string, int>& roots,
+                 const std::unordered_set<std::string>& non_scalar):
+  nodes(nodes), roots(roots), non_scalar(non_scalar){}
+
+  // only algebras that are known to result in a 1x1 matrix can be packed
+  bool is_scalar(const int id){
+    const algebra_node& node = nodes[id];
+    switch(node.type){
+    case node_type::number:
+      return(true);
+    case node_type::symbol:{
+      if(non_scalar.count(node.text) != 0)
+        return(false);
+      auto root = roots.find(node.text);
+      if(root == roots.end())
+        // parameter labels and definition variables
+        return(true);
+      return(is_scalar_algebra(node.text, root->second));
+    }
+    case node_type::index:
+      for(std::size_t i = 1; i < node.children.size(); i++){
+        if(nodes[node.children[i]].text.empty())
+          return(false);
+      }
+      return(true);
+    case node_type::unary:
+      return(is_scalar(node.children[0]));
+    case node_type::binary:
+      return(node.text != ":" &&
+             is_scalar(node.children[0]) &&
+             is_scalar(node.children[1]));
+    case node_type::call:
+      if(!is_elementwise_function(node.text) || node.children.size() != 1)
+        return(false);
+      return(is_scalar(node.children[0]));
+    }
+    return(false);
+  }
+
+  // definition variables the algebra depends on, including those of all
+  // algebras used in the algebra
+  void definition_variables(const int id, std::set<std::string>& found){
+    const algebra_node& node = nodes[id];
+    if(node.type == node_type::symbol){
+      if(node.text.rfind("data.", 0) == 0){
+        found.insert(node.text);
+      }else{
+        auto root = roots.find(node.text);
+        if(root != roots.end() && visiting.insert(node.text).second){
+          definition_variables(root->second, found);
+          visiting.erase(node.text);
+        }
+      }
+    }
+    for(int child: node.children)
+      definition_variables(child, found);
+  }
+
+private:
+  const std::vector<algebra_node>& nodes;
+  const std::unordered_map<std::string, int>& roots;
+  const std::unordered_set<std::string>& non_scalar;
+  std::unordered_map<std::string, bool> scalar_algebras;
+  std::unordered_set<std::string> visiting;
+
+  bool is_scalar_algebra(const std::string& name, const int root){
+    auto known = scalar_algebras.find(name);
+    if(known != scalar_algebras.end())
+      return(known->second);
+    // algebras that refer to themselves are not scalar
+    if(!visiting.insert(name).second)
+      return(false);
+    const bool scalar = is_scalar(root);
+    visiting.erase(name);
+    scalar_algebras[name] = scalar;
+    return(scalar);
+  }
+};
+
+struct packed_algebras{
+  std::vector<std::string> lhs, rhs;
+  // labels of packed algebras and the element of the packed algebra that
+  // replaces them
+  std::vector<std::string> labels, references;
+};
+
+static packed_algebras pack_algebras(const std::vector<std::string>& lhs,
+                                     const std::vector<std::string>& rhs,
+                                     const std::vector<std::string>& user_defined){
+  std::vector<algebra_node> nodes;
+  std::vector<int> roots;
+  std::unordered_map<std::string, int> root_of;
+  algebra_parser parser(nodes);
+  bool all_parsed = true;
+  for(std::size_t i = 0; i < lhs.size(); i++){
+    int root = parser.parse(rhs[i]);
+    if(root < 0){
+      all_parsed = false;
+      break;
+    }
+    roots.push_back(root);
+    root_of[lhs[i]] = root;
+  }
+
+  packed_algebras result;
+
+  if(!all_parsed){
+    // algebras we cannot parse are passed on to OpenMx unchanged
+    result.lhs = lhs;
+    result.rhs = rhs;
+  }else{
+    // the RAM matrices and all elements of user defined code may be
+    // matrices of any size
+    std::unordered_set<std::string> non_scalar = {"A", "S", "M", "F", "new_parameters"};
+    for(const std::string& code: user_defined){
+      for(std::string_view symbol: algebra_parser::symbols(code))
+        non_scalar.emplace(symbol);
+    }
+
+    std::unordered_set<std::string> used_names(lhs.begin(), lhs.end());
+    std::unordered_set<std::string> used_in_algebras;
+    for(int root: roots)
+      collect_symbols(nodes, root, used_in_algebras);
+    used_names.insert(used_in_algebras.begin(), used_in_algebras.end());
+    used_names.insert(non_scalar.begin(), non_scalar.end());
+
+    algebra_packer packer(nodes, root_of, non_scalar);
+
+    // algebras are grouped by their definition variables; groups are kept in
+    // the order of their first algebra
+    std::vector<std::string> group_keys;
+    std::map<std::string, std::vector<std::size_t>> groups;
+    std::vector<bool> is_packed(lhs.size(), false);
+    for(std::size_t i = 0; i < lhs.size(); i++){
+      if(used_in_algebras.count(lhs[i]) != 0 ||
+         non_scalar.count(lhs[i]) != 0 ||
+         !packer.is_scalar(roots[i]))
+        continue;
+      std::set<std::string> definition_variables;
+      packer.definition_variables(roots[i], definition_variables);
+      std::string key;
+      for(const std::string& definition_variable: definition_variables)
+        key += definition_variable + ",";
+      if(groups.count(key) == 0)
+        group_keys.push_back(key);
+      groups[key].push_back(i);
+    }
+
+    for(const std::string& key: group_keys){
+      // packing a single algebra does not save anything
+      if(groups[key].size() > 1){
+        for(std::size_t i: groups[key])
+          is_packed[i] = true;
+      }
+    }
+
+    for(std::size_t i = 0; i < lhs.size(); i++){
+      if(is_packed[i])
+        continue;
+      result.lhs.push_back(lhs[i]);
+      result.rhs.push_back(rhs[i]);
+    }
+
+    int n_packed = 0;
+    for(const std::string& key: group_keys){
+      const std::vector<std::size_t>& group = groups[key];
+      if(group.size() < 2)
+        continue;
+      std::string name;
+      do{
+        name = "mxsem_packed_" + std::to_string(++n_packed);
+      }while(used_names.count(name) != 0);
+
+      std::string packed_rhs = "cbind(";
+      for(std::size_t element = 0; element < group.size(); element++){
+        if(element != 0)
+          packed_rhs += ", ";
+        packed_rhs += node_to_string(nodes, roots[group[element]]);
+        result.labels.push_back(lhs[group[element]]);
+        result.references.push_back(name + "[1," + std::to_string(element + 1) + "]");
+      }
+      packed_rhs += ")";
+      result.lhs.push_back(name);
+      result.rhs.push_back(packed_rhs);
+    }
+  }
+  return(result);
+}
+
+//' pack_algebras_rcpp
+//'
+//' combines scalar algebras that depend on the same definition variables into
+//' one vector valued algebra. OpenMx then evaluates one algebra per data row
+//' instead of one algebra per parameter. Algebras used in other algebras or
+//' in user defined elements are not packed.
+//' @param lhs names of the algebras
+//' @param rhs the algebras
+//' @param user_defined user defined elements
+//' @return list with the algebras (data.frame with lhs, op, and rhs) and the
+//' references (data.frame with label and reference). In the model, the labels
+//' of packed algebras must be replaced with their reference (e.g., mxsem_packed_1[1,2]).
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::List pack_algebras_rcpp(const std::vector<std::string>& lhs,
+                              const std::vector<std::string>& rhs,
+                              const std::vector<std::string>& user_defined){
+  if(lhs.size() != rhs.size())
+    Rcpp::stop("lhs and rhs of the algebras must be of the same length.");
+
+  packed_algebras result = pack_algebras(lhs, rhs, user_defined);
+
+  const R_xlen_t n_algebras = static_cast<R_xlen_t>(result.lhs.size());
+  Rcpp::List algebras = make_data_frame(
+    Rcpp::List::create(Rcpp::wrap(result.lhs),
+                       Rcpp::wrap(std::vector<std::string>(result.lhs.size(), ":=")),
+                       Rcpp::wrap(result.rhs)),
+    Rcpp::CharacterVector::create("lhs", "op", "rhs"),
+    n_algebras);
+  Rcpp::List references = make_data_frame(
+    Rcpp::List::create(Rcpp::wrap(result.labels),
+                       Rcpp::wrap(result.references)),
+    Rcpp::CharacterVector::create("label", "reference"),
+    static_cast<R_xlen_t>(result.labels.size()));
+
+  return(Rcpp::List::create(Rcpp::Named("algebras") = algebras,
+                            Rcpp::Named("references") = references));
+}
@@ -1,33 +1,55 @@
 #ifndef PARAMETER_TABLE_H
 #define PARAMETER_TABLE_H
 #include <Rcpp.h>
+#include <memory_resource>
+
+// All strings of a parameter table are allocated from the memory resource
+// passed to the constructor. make_parameter_table uses a monotonic arena that
+// is released in one step once the table was copied to R.
+typedef std::pmr::string pt_string;
+typedef std::pmr::vector<std::pmr::string> pt_column;
 
 struct algebra{
-  std::vector<std::string> new_parameters;
-  std::vector<std::string> new_parameters_free;
-  std::vector<std::string> lhs, op, rhs;
+  pt_column new_parameters;
+  pt_column new_parameters_free;
+  pt_column lhs, op, rhs;
+
+  explicit algebra(std::pmr::memory_resource* mr = std::pmr::get_default_resource()):
+    new_parameters(mr), new_parameters_free(mr),
+    lhs(mr), op(mr), rhs(mr){}
 };
 
 struct variables{
-  std::vector<std::string> manifests;
-  std::vector<std::string> latents;
+  pt_column manifests;
+  pt_column latents;
+
+  explicit variables(std::pmr::memory_resource* mr = std::pmr::get_default_resource()):
+    manifests(mr), latents(mr){}
 };
 
 class parameter_table{
 public:
-  std::vector<std::string> lhs, op, rhs, modifier, lbound, ubound, free;
-  std::vector<std::string> user_defined;
+  pt_column lhs, op, rhs, modifier, lbound, ubound, free;
+  pt_column user_defined;
   algebra alg;
   variables vars;
 
+  explicit parameter_table(std::pmr::memory_resource* mr = std::pmr::get_default_resource()):
+    lhs(mr), op(mr), rhs(mr), modifier(mr), lbound(mr), ubound(mr), free(mr),
+    user_defined(mr), alg(mr), vars(mr){}
+
+  std::pmr::memory_resource* resource() const{
+    return(lhs.get_allocator().resource());
+  }
+
   void add_line(){
-    lhs.push_back("");
-    op.push_back("");
-    rhs.push_back("");
-    modifier.push_back("");
-    lbound.push_back("");
-    ubound.push_back("");
-    free.push_back("TRUE");
+    lhs.emplace_back();
+    op.emplace_back();
+    rhs.emplace_back();
+    modifier.emplace_back();
+    lbound.emplace_back();
+    ubound.emplace_back();
+    free.emplace_back("TRUE");
   }
 };
 
@@ -0,0 +1,115 @@
+#include <Rcpp.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "make_parameter_table.h"
+#include "model_blocks.h"
+#include "model_handle.h"
+#include "diagnostics.h"
+#include "r_conversion.h"
+
+//' parameter_tables_rcpp
+//'
+//' creates parameter tables for all models in a lavaan like syntax. Each model
+//' starts with a header of the form ===model_name===.
+//' @param syntax lavaan like syntax with one or multiple models
+//' @param add_intercept should intercepts for manifest variables be automatically added?
+//' @param add_variance should variances for all variables be automatically added?
+//' @param add_exogenous_latent_covariances should covariances between exogenous latent variables be
+//' added automatically?
+//' @param add_exogenous_manifest_covariances should covariances between exogenous manifest variables be
+//' added automatically?
+//' @param scale_latent_variance should variances of latent variables be set to 1?
+//' @param scale_loading should the first loading of each latent variable be set to 1?
+//' @param n_threads number of threads used to parse the models
+//' @return named list with one parameter table (see parameter_table_rcpp) for each model
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::List parameter_tables_rcpp(const std::string& syntax,
+                                 bool add_intercept,
+                                 bool add_variance,
+                                 bool add_exogenous_latent_covariances,
+                                 bool add_exogenous_manifest_covariances,
+                                 bool scale_latent_variance,
+                                 bool scale_loading,
+                                 int n_threads = 1){
+
+  const std::vector<model_block> blocks = find_model_blocks(syntax);
+
+  for(unsigned int i = 0; i < blocks.size(); i++){
+    if(blocks.at(i).syntax_end == blocks.at(i).syntax_start)
+      Rcpp::stop("Found no model in your syntax for model " + blocks.at(i).name + ".");
+    for(unsigned int j = 0; j < i; j++){
+      if(blocks.at(i).name.compare(blocks.at(j).name) == 0)
+        Rcpp::stop("Found multiple models with the name " + blocks.at(i).name + ".");
+    }
+  }
+
+  // Each model is parsed into its own arena. Because the models are
+  // independent, they can be parsed on separate threads. The parser must not
+  // call R outside of the main thread; warnings and errors are therefore
+  // collected and forwarded to R once all models were parsed.
+  std::vector<std::unique_ptr<model_handle>> models(blocks.size());
+  std::vector<parse_diagnostics> diagnostics(blocks.size());
+  std::vector<std::string> errors(blocks.size());
+  // not std::vector<bool>: its elements cannot be written from separate threads
+  std::vector<char> failed(blocks.size(), false);
+
+  std::atomic<std::size_t> next_block{0};
+
+  auto parse_blocks = [&](){
+    for(std::size_t b = next_block++; b < blocks.size(); b = next_block++){
+      collect_diagnostics collect(diagnostics.at(b));
+      try{
+        std::string_view block_syntax = std::string_view(syntax).substr(
+          blocks.at(b).syntax_start,
+          blocks.at(b).syntax_end - blocks.at(b).syntax_start);
+
+        models.at(b) = std::make_unique<model_handle>(4 * block_syntax.size() + 1024);
+        models.at(b)->pt = make_parameter_table(block_syntax,
+                                                &models.at(b)->arena,
+                                                add_intercept,
+                                                add_variance,
+                                                add_exogenous_latent_covariances,
+                                                add_exogenous_manifest_covariances,
+                                                scale_latent_variance,
+                                                scale_loading);
+      }catch(const std::exception& e){
+        failed.at(b) = true;
+        errors.at(b) = e.what();
+      }
+    }
+  };
+
+  const std::size_t n_workers = std::min<std::size_t>(std::max(n_threads, 1), blocks.size());
+  if(n_workers <= 1){
+    parse_blocks();
+  }else{
+    std::vector<std::thread> workers;
+    for(std::size_t w = 0; w < n_workers; w++)
+      workers.emplace_back(parse_blocks);
+    for(std::thread& worker: workers)
+      worker.join();
+  }
+
+  // report in the order of the models in the syntax
+  for(unsigned int b = 0; b < blocks.size(); b++){
+    parse_diagnostics named_diagnostics = diagnostics.at(b);
+    for(diagnostic& d: named_diagnostics)
+      d.text = "In model " + blocks.at(b).name + ": " + d.text;
+    replay_diagnostics(named_diagnostics);
+
+    if(failed.at(b))
+      Rcpp::stop("In model " + blocks.at(b).name + ": " + errors.at(b));
+  }
+
+  Rcpp::List parameter_tables(blocks.size());
+  Rcpp::CharacterVector model_names(blocks.size());
+  for(unsigned int b = 0; b < blocks.size(); b++){
+    parameter_tables[b] = parameter_table_to_r(models.at(b)->pt);
+    model_names[b] = blocks.at(b).name;
+  }
+  parameter_tables.attr("names") = model_names;
+
+  return(parameter_tables);
+}
@@ -0,0 +1,164 @@
+#include <Rcpp.h>
+#include "make_parameter_table.h"
+#include "clean_syntax.h"
+#include "check_syntax.h"
+#include "diagnostics.h"
+#include "r_conversion.h"
+
+static bool is_path_operator(std::string_view op){
+  return((op == "=~") || (op == "~~") || (op == "~"));
+}
+
+static void check_name(std::string_view name,
+                       std::string_view side,
+                       std::size_t row){
+  if(name.empty() || (find_invalid_name_char(name) != std::string_view::npos))
+    parse_stop("The following " + std::string(side) + " in row " + std::to_string(row + 1) +
+      " of the parameter table does not match the allowed pattern of letters digits and underscores: " +
+      std::string(name));
+}
+
+parameter_table make_parameter_table(const std::vector<partable_row>& rows,
+                                     std::pmr::memory_resource* mr,
+                                     bool add_intercept,
+                                     bool add_variance,
+                                     bool add_exogenous_latent_covariances,
+                                     bool add_exogenous_manifest_covariances,
+                                     bool scale_latent_variance,
+                                     bool scale_loading){
+  parameter_table pt(mr);
+
+  // Paths are added directly. Bounds on labels, equality constraints, and
+  // algebras are passed to the second stage of the parser as cleaned equations
+  // (e.g., a>0 or a==b) so that they are resolved exactly as in a syntax.
+  pt_column equations(mr);
+  pt_string equation(mr);
+
+  for(std::size_t i = 0; i < rows.size(); i++){
+    const partable_row& row = rows.at(i);
+
+    if(is_path_operator(row.op) || (row.op == "~1")){
+      // lavaan writes intercepts as y ~1 with an empty right hand side; the
+      // syntax (and the parameter table) uses y ~ 1
+      const bool is_intercept = (row.op == "~1");
+      check_name(row.lhs, "left hand side", i);
+      if(is_intercept && !row.rhs.empty())
+        parse_stop("The right hand side in row " + std::to_string(i + 1) +
+          " of the parameter table must be empty for the operator ~1.");
+      if(!is_intercept)
+        check_name(row.rhs, "right hand side", i);
+      if(!row.modifier.empty())
+        check_modifier(row.modifier);
+
+      pt.add_line();
+      pt.lhs.back() = row.lhs;
+      if(is_intercept){
+        pt.op.back() = "~";
+        pt.rhs.back() = "1";
+      }else{
+        pt.op.back() = row.op;
+        pt.rhs.back() = row.rhs;
+      }
+      pt.modifier.back() = row.modifier;
+      pt.lbound.back() = row.lbound;
+      pt.ubound.back() = row.ubound;
+    }else if((row.op == ">") || (row.op == "<") || (row.op == "==") || (row.op == ":=")){
+      equation.assign(row.lhs);
+      equation.append(row.op);
+      equation.append(row.rhs);
+      for(pt_string& cleaned: clean_syntax(equation, mr))
+        equations.push_back(std::move(cleaned));
+    }else{
+      parse_stop("Unknown operator " + std::string(row.op) + " in row " + std::to_string(i + 1) +
+        " of the parameter table. Supported operators are =~, ~~, ~, ~1, :=, ==, >, and <.");
+    }
+  }
+
+  complete_parameter_table(equations,
+                           pt,
+                           0,
+                           1,
+                           add_intercept,
+                           add_variance,
+                           add_exogenous_latent_covariances,
+                           add_exogenous_manifest_covariances,
+                           scale_latent_variance,
+                           scale_loading);
+
+  return(pt);
+}
+
+//' parameter_table_from_partable_rcpp
+//'
+//' creates a parameter table from the columns of a lavaan-style parameter table
+//' instead of a syntax. The rows are validated and completed (e.g., variances,
+//' intercepts, and scaling) exactly as in parameter_table_rcpp. All columns must
+//' be character vectors of the same length; use empty strings for missing
+//' modifiers and bounds.
+//' @param lhs left hand side of each row
+//' @param op operator of each row (=~, ~~, ~, ~1, :=, ==, >, or <)
+//' @param rhs right hand side of each row
+//' @param modifier modifier (label or value) of each path
+//' @param lbound lower bound of each path
+//' @param ubound upper bound of each path
+//' @param add_intercept should intercepts for manifest variables be automatically added?
+//' @param add_variance should variances for all variables be automatically added?
+//' @param add_exogenous_latent_covariances should covariances between exogenous latent variables be
+//' added automatically?
+//' @param add_exogenous_manifest_covariances should covariances between exogenous manifest variables be
+//' added automatically?
+//' @param scale_latent_variance should variances of latent variables be set to 1?
+//' @param scale_loading should the first loading of each latent variable be set to 1?
+//' @return parameter table (see parameter_table_rcpp)
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::List parameter_table_from_partable_rcpp(Rcpp::CharacterVector lhs,
+                                              Rcpp::CharacterVector op,
+                                              Rcpp::CharacterVector rhs,
+                                              Rcpp::CharacterVector modifier,
+                                              Rcpp::CharacterVector lbound,
+                                              Rcpp::CharacterVector ubound,
+                                              bool add_intercept,
+                                              bool add_variance,
+                                              bool add_exogenous_latent_covariances,
+                                              bool add_exogenous_manifest_covariances,
+                                              bool scale_latent_variance,
+                                              bool scale_loading){
+  const R_xlen_t n_rows = lhs.size();
+  for(const Rcpp::CharacterVector* column: {&op, &rhs, &modifier, &lbound, &ubound}){
+    if(column->size() != n_rows)
+      Rcpp::stop("All columns of the parameter table must have the same length.");
+  }
+
+  // the rows are views into R's strings; they are copied once into the
+  // arena of the parameter table.
+  auto element = [](const Rcpp::CharacterVector& column, R_xlen_t i) -> std::string_view {
+    SEXP str = STRING_ELT(column, i);
+    if(str == NA_STRING)
+      return(std::string_view());
+    return(std::string_view(CHAR(str), Rf_xlength(str)));
+  };
+
+  std::vector<partable_row> rows(n_rows);
+  std::size_t n_chars = 0;
+  for(R_xlen_t i = 0; i < n_rows; i++){
+    rows[i] = {element(lhs, i), element(op, i), element(rhs, i),
+               element(modifier, i), element(lbound, i), element(ubound, i)};
+    n_chars += rows[i].lhs.size() + rows[i].rhs.size() + rows[i].modifier.size();
+  }
+
+  std::pmr::monotonic_buffer_resource arena(4 * n_chars + 1024);
+
+  parameter_table pt = make_parameter_table(rows,
+                                            &arena,
+                                            add_intercept,
+                                            add_variance,
+                                            add_exogenous_latent_covariances,
+                                            add_exogenous_manifest_covariances,
+                                            scale_latent_variance,
+                                            scale_loading);
+
+  // The arena must outlive the conversion: the cached R strings are looked up
+  // by views into the parameter table.
+  return(parameter_table_to_r(pt));
+}
@@ -0,0 +1,204 @@
+#include <Rcpp.h>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <string>
+#include "person_models.h"
+#include "r_conversion.h"
+
+// Cholesky factor of the implied covariance matrix of the manifest variables
+// that were observed for a person. The factor only depends on the implied
+// moments and the missingness pattern and is reused for all persons with the
+// same definition variables and missingness pattern.
+class observed_moments{
+public:
+  explicit observed_moments(const person_model& model):
+  model(model){}
+
+  // returns false if the implied covariance matrix of the observed variables is
+  // not positive definite
+  bool update(const person_moments& moments, const std::size_t row){
+    observed.clear();
+    for(std::size_t m = 0; m < model.manifests.size(); m++){
+      if(!std::isnan(model.observed[m][row]))
+        observed.push_back(m);
+    }
+    const std::size_t n_observed = observed.size();
+    mean.resize(n_observed);
+    covariance = dense_matrix(n_observed, n_observed);
+    for(std::size_t o = 0; o < n_observed; o++){
+      const std::size_t variable = model.manifests[observed[o]];
+      mean[o] = moments.mean[variable];
+      for(std::size_t p = 0; p < n_observed; p++)
+        covariance(p, o) = moments.covariance(model.manifests[observed[p]], variable);
+    }
+    if(!cholesky(covariance))
+      return(false);
+    log_determinant = cholesky_log_determinant(covariance);
+    residual.resize(n_observed);
+    return(true);
+  }
+
+  std::size_t n_observed() const{
+    return(observed.size());
+  }
+
+  // squared Mahalanobis distance of the observed values of a person
+  double mahalanobis(const std::size_t row){
+    // with L L^T = Sigma, the distance is |L^-1 (x - mean)|^2
+    double distance = 0.0;
+    for(std::size_t i = 0; i < observed.size(); i++){
+      double value = model.observed[observed[i]][row] - mean[i];
+      for(std::size_t k = 0; k < i; k++)
+        value -= covariance(i, k) * residual[k];
+      residual[i] = value / covariance(i, i);
+      distance += residual[i] * residual[i];
+    }
+    return(distance);
+  }
+
+  double log_likelihood(const double mahalanobis) const{
+    // log(2 pi)
+    static constexpr double log_2_pi = 1.8378770664093454836;
+    return(-0.5 * (static_cast<double>(observed.size()) * log_2_pi + log_determinant + mahalanobis));
+  }
+
+private:
+  const person_model& model;
+  std::vector<std::size_t> observed;
+  std::vector<double> mean;
+  // Cholesky factor
+  dense_matrix covariance;
+  double log_determinant = 0.0;
+  std::vector<double> residual;
+};
+
+struct person_fit_result{
+  std::vector<int> n_observed;
+  std::vector<double> log_likelihood;
+  std::vector<double> mahalanobis;
+  // implied means (one vector per manifest variable) and covariances (one
+  // vector per element of the lower triangle); empty if not requested
+  std::vector<std::vector<double>> means;
+  std::vector<std::vector<double>> covariances;
+  std::size_t n_failed = 0;
+};
+
+static person_fit_result compute_person_fit(const person_model& model,
+                                            const bool implied_moments,
+                                            const std::size_t n_threads){
+  const std::size_t n_manifests = model.manifests.size();
+  person_fit_result result;
+  result.n_observed.resize(model.n_rows, 0);
+  result.log_likelihood.resize(model.n_rows, NAN);
+  result.mahalanobis.resize(model.n_rows, NAN);
+  if(implied_moments){
+    result.means.resize(n_manifests, std::vector<double>(model.n_rows, NAN));
+    result.covariances.resize(n_manifests * (n_manifests + 1) / 2, std::vector<double>(model.n_rows, NAN));
+  }
+
+  const std::vector<std::size_t> order = model.row_order();
+  std::mutex failures_mutex;
+
+  for_each_chunk_parallel(order.size(), n_threads, [&](std::size_t first, std::size_t last){
+    person_moments moments(model);
+    observed_moments factorization(model);
+    bool is_valid = false;
+    std::size_t failed = 0;
+    for(std::size_t i = first; i < last; i++){
+      const std::size_t row = order[i];
+      const bool changed = moments.set_row(row);
+      if(changed || (i == first) || !model.same_missingness(order[i - 1], row))
+        is_valid = factorization.update(moments, row);
+
+      if(implied_moments){
+        std::size_t element = 0;
+        for(std::size_t m = 0; m < n_manifests; m++){
+          result.means[m][row] = moments.mean[model.manifests[m]];
+          for(std::size_t k = m; k < n_manifests; k++)
+            result.covariances[element++][row] = moments.covariance(model.manifests[k], model.manifests[m]);
+        }
+      }
+
+      result.n_observed[row] = static_cast<int>(factorization.n_observed());
+      if(!is_valid){
+        failed++;
+        continue;
+      }
+      const double distance = factorization.mahalanobis(row);
+      result.mahalanobis[row] = distance;
+      result.log_likelihood[row] = factorization.log_likelihood(distance);
+    }
+    std::lock_guard<std::mutex> lock(failures_mutex);
+    result.n_failed += failed;
+  });
+  return(result);
+}
+
+static Rcpp::NumericVector to_r(const std::vector<double>& values){
+  Rcpp::NumericVector r_values(values.size());
+  for(std::size_t i = 0; i < values.size(); i++)
+    r_values[i] = std::isnan(values[i]) ? NA_REAL : values[i];
+  return(r_values);
+}
+
+//' person_fit_rcpp
+//'
+//' computes the log-likelihood contribution (full information maximum likelihood) and
+//' the squared Mahalanobis distance of each person in the data of a RAM model. Elements
+//' of the model that depend on definition variables are evaluated for each person.
+//' The implied moments are only recomputed if the definition variables change and the
+//' Cholesky factor of the implied covariance matrix is only recomputed if the definition
+//' variables or the missingness pattern change. To this end, the persons are processed in
+//' the order of their definition variables and missingness patterns.
+//' @param model list created with prepare_person_model
+//' @param data raw data
+//' @param implied_moments should the implied means and covariances of the manifest variables
+//' be returned for each person?
+//' @param n_threads number of threads. Each thread processes a chunk of the persons.
+//' @return list with a data.frame with one row per person (fit) and the number of persons
+//' whose implied covariance matrix is not positive definite (n_failed). The data.frame holds the
+//' number of observed manifest variables (n_observed), the log-likelihood contribution (log_likelihood),
+//' the squared Mahalanobis distance (mahalanobis), and, if implied_moments is TRUE, the implied means
+//' (mean_variable) and covariances (cov_variable1_variable2) of the manifest variables. The
+//' log-likelihood and Mahalanobis distance of persons whose implied covariance matrix is not
+//' positive definite are NA.
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::List person_fit_rcpp(Rcpp::List model,
+                           Rcpp::List data,
+                           bool implied_moments = false,
+                           int n_threads = 1){
+  const std::vector<std::string> manifests = Rcpp::as<std::vector<std::string>>(model["manifests"]);
+  const person_model persons(read_person_model(model, data));
+  person_fit_result result = compute_person_fit(persons,
+                                                implied_moments,
+                                                static_cast<std::size_t>(std::max(n_threads, 1)));
+
+  const std::size_t n_manifests = manifests.size();
+  const std::size_t n_columns = 3 + (implied_moments ? n_manifests + n_manifests * (n_manifests + 1) / 2 : 0);
+  Rcpp::List columns(static_cast<R_xlen_t>(n_columns));
+  Rcpp::CharacterVector column_names(static_cast<R_xlen_t>(n_columns));
+  R_xlen_t column = 0;
+  auto add_column = [&](SEXP values, const std::string& name){
+    columns[column] = values;
+    column_names[column++] = name;
+  };
+  add_column(Rcpp::wrap(result.n_observed), "n_observed");
+  add_column(to_r(result.log_likelihood), "log_likelihood");
+  add_column(to_r(result.mahalanobis), "mahalanobis");
+  if(implied_moments){
+    for(std::size_t m = 0; m < n_manifests; m++)
+      add_column(to_r(result.means[m]), "mean_" + manifests[m]);
+    std::size_t element = 0;
+    for(std::size_t m = 0; m < n_manifests; m++){
+      for(std::size_t k = m; k < n_manifests; k++)
+        add_column(to_r(result.covariances[element++]), "cov_" + manifests[k] + "_" + manifests[m]);
+    }
+  }
+
+  return(Rcpp::List::create(Rcpp::Named("fit") = make_data_frame(columns,
+                                                                  column_names,
+                                                                  static_cast<R_xlen_t>(persons.n_rows)),
+                            Rcpp::Named("n_failed") = static_cast<int>(result.n_failed)));
+}
@@ -0,0 +1,542 @@
+#include <Rcpp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+#include <thread>
+#include "person_models.h"
+#include "r_conversion.h"
+
+bool cholesky(dense_matrix& m){
+  const std::size_t n = m.n_rows;
+  for(std::size_t j = 0; j < n; j++){
+    double diagonal = m(j, j);
+    for(std::size_t k = 0; k < j; k++)
+      diagonal -= m(j, k) * m(j, k);
+    // also catches NaN
+    if(!(diagonal > 0.0))
+      return(false);
+    diagonal = std::sqrt(diagonal);
+    m(j, j) = diagonal;
+    for(std::size_t i = j + 1; i < n; i++){
+      double value = m(i, j);
+      for(std::size_t k = 0; k < j; k++)
+        value -= m(i, k) * m(j, k);
+      m(i, j) = value / diagonal;
+    }
+    for(std::size_t i = 0; i < j; i++)
+      m(i, j) = 0.0;
+  }
+  return(true);
+}
+
+void cholesky_solve(const dense_matrix& l, dense_matrix& b){
+  const std::size_t n = l.n_rows;
+  for(std::size_t c = 0; c < b.n_cols; c++){
+    // L y = b
+    for(std::size_t i = 0; i < n; i++){
+      double value = b(i, c);
+      for(std::size_t k = 0; k < i; k++)
+        value -= l(i, k) * b(k, c);
+      b(i, c) = value / l(i, i);
+    }
+    // L^T x = y
+    for(std::size_t i = n; i-- > 0;){
+      double value = b(i, c);
+      for(std::size_t k = i + 1; k < n; k++)
+        value -= l(k, i) * b(k, c);
+      b(i, c) = value / l(i, i);
+    }
+  }
+}
+
+double cholesky_log_determinant(const dense_matrix& l){
+  double log_determinant = 0.0;
+  for(std::size_t i = 0; i < l.n_rows; i++)
+    log_determinant += 2.0 * std::log(l(i, i));
+  return(log_determinant);
+}
+
+bool invert(dense_matrix& m){
+  const std::size_t n = m.n_rows;
+  dense_matrix inverse(n, n);
+  for(std::size_t i = 0; i < n; i++)
+    inverse(i, i) = 1.0;
+
+  for(std::size_t c = 0; c < n; c++){
+    std::size_t pivot = c;
+    for(std::size_t r = c + 1; r < n; r++){
+      if(std::abs(m(r, c)) > std::abs(m(pivot, c)))
+        pivot = r;
+    }
+    if(!(std::abs(m(pivot, c)) > 0.0))
+      return(false);
+    if(pivot != c){
+      for(std::size_t k = 0; k < n; k++){
+        std::swap(m(c, k), m(pivot, k));
+        std::swap(inverse(c, k), inverse(pivot, k));
+      }
+    }
+    const double scale = 1.0 / m(c, c);
+    for(std::size_t k = 0; k < n; k++){
+      m(c, k) *= scale;
+      inverse(c, k) *= scale;
+    }
+    for(std::size_t r = 0; r < n; r++){
+      const double factor = m(r, c);
+      if(r == c || factor == 0.0)
+        continue;
+      for(std::size_t k = 0; k < n; k++){
+        m(r, k) -= factor * m(c, k);
+        inverse(r, k) -= factor * inverse(c, k);
+      }
+    }
+  }
+  m = std::move(inverse);
+  return(true);
+}
+
+// functions that can be used in person-specific algebras. These are the
+// functions that return a 1x1 matrix when called with a 1x1 matrix.
+static double (*find_function(const std::string& name))(double){
+  static const std::pair<const char*, double (*)(double)> functions[] = {
+    {"exp", [](double x){ return(std::exp(x)); }},
+    {"log", [](double x){ return(std::log(x)); }},
+    {"sqrt", [](double x){ return(std::sqrt(x)); }},
+    {"abs", [](double x){ return(std::abs(x)); }},
+    {"sin", [](double x){ return(std::sin(x)); }},
+    {"cos", [](double x){ return(std::cos(x)); }},
+    {"tan", [](double x){ return(std::tan(x)); }},
+    {"sinh", [](double x){ return(std::sinh(x)); }},
+    {"cosh", [](double x){ return(std::cosh(x)); }},
+    {"tanh", [](double x){ return(std::tanh(x)); }}
+  };
+  for(const auto& function: functions){
+    if(name == function.first)
+      return(function.second);
+  }
+  return(nullptr);
+}
+
+static std::size_t find_variable(const std::vector<std::string>& variables,
+                                 const std::string& name){
+  auto found = std::find(variables.begin(), variables.end(), name);
+  if(found == variables.end())
+    Rcpp::stop("Could not find the variable " + name + " in the model.");
+  return(static_cast<std::size_t>(found - variables.begin()));
+}
+
+// definition variables are compared numerically; missing values come last
+static int compare_values(const double a, const double b){
+  const bool a_missing = std::isnan(a);
+  const bool b_missing = std::isnan(b);
+  if(a_missing || b_missing)
+    return(static_cast<int>(a_missing) - static_cast<int>(b_missing));
+  return((a > b) - (a < b));
+}
+
+person_model::person_model(const person_model_input& input):
+  n_rows(input.n_rows){
+  const std::size_t n_variables = input.variables.size();
+  if((input.A.size() != n_variables * n_variables) ||
+     (input.S.size() != n_variables * n_variables) ||
+     (!input.M.empty() && input.M.size() != n_variables))
+    Rcpp::stop("The dimensions of the A, S, and M matrices do not match the number of variables.");
+
+  A = dense_matrix(n_variables, n_variables);
+  A.values = input.A;
+  S = dense_matrix(n_variables, n_variables);
+  S.values = input.S;
+  M = input.M.empty() ? std::vector<double>(n_variables, 0.0) : input.M;
+
+  for(const std::string& manifest: input.manifests)
+    manifests.push_back(find_variable(input.variables, manifest));
+  for(std::size_t v = 0; v < n_variables; v++){
+    if(std::find(manifests.begin(), manifests.end(), v) == manifests.end()){
+      latents.push_back(v);
+      latent_names.push_back(input.variables[v]);
+    }
+  }
+
+  for(const std::string& manifest: input.manifests){
+    observed.push_back(input.read_column(manifest));
+    if(observed.back().size() != n_rows)
+      Rcpp::stop("The variable " + manifest + " has the wrong number of rows.");
+  }
+
+  // missingness patterns
+  missingness.resize(n_rows);
+  std::unordered_map<std::string, std::size_t> patterns;
+  std::string pattern(manifests.size(), '0');
+  for(std::size_t row = 0; row < n_rows; row++){
+    for(std::size_t m = 0; m < manifests.size(); m++)
+      pattern[m] = std::isnan(observed[m][row]) ? '1' : '0';
+    missingness[row] = patterns.emplace(pattern, patterns.size()).first->second;
+  }
+
+  // the labels of the person-specific elements and all algebras are parsed
+  // into one pool. Algebras that cannot be parsed are only an error if a
+  // person-specific element depends on them.
+  algebra_parser parser(nodes);
+  std::unordered_map<std::string, int> algebra_roots;
+  for(std::size_t a = 0; a < input.algebra_names.size(); a++)
+    algebra_roots[input.algebra_names[a]] = parser.parse(input.algebra_formulas[a]);
+
+  std::unordered_map<std::string, std::size_t> definition_variables;
+  for(std::size_t e = 0; e < input.element_label.size(); e++){
+    const std::string& matrix = input.element_matrix[e];
+    if((matrix != "A") && (matrix != "S") && (matrix != "M"))
+      Rcpp::stop("Person-specific elements must be in the A, S, or M matrix.");
+    if((input.element_row[e] >= n_variables) || (input.element_col[e] >= n_variables))
+      Rcpp::stop("The person-specific element " + input.element_label[e] + " is outside of the " +
+        matrix + " matrix.");
+
+    const int root = parser.parse(input.element_label[e]);
+    if(root < 0)
+      Rcpp::stop("Could not parse the label " + input.element_label[e] + ".");
+    resolved.resize(nodes.size());
+    resolve(root, input.element_label[e], input, algebra_roots, definition_variables);
+
+    elements.push_back({matrix[0], input.element_row[e], input.element_col[e], root});
+    A_is_person_specific = A_is_person_specific || (matrix == "A");
+  }
+
+  definition_values.resize(definition_variables.size());
+  for(const auto& definition_variable: definition_variables){
+    std::vector<double>& values = definition_values[definition_variable.second];
+    values = input.read_column(definition_variable.first.substr(5));
+    if(values.size() != n_rows)
+      Rcpp::stop("The definition variable " + definition_variable.first + " has the wrong number of rows.");
+  }
+}
+
+void person_model::resolve(const int id,
+                           const std::string& algebra,
+                           const person_model_input& input,
+                           const std::unordered_map<std::string, int>& algebra_roots,
+                           std::unordered_map<std::string, std::size_t>& definition_variables){
+  if(resolved[id].type != resolved_type::unresolved)
+    return;
+  resolved_node& node = resolved[id];
+  const algebra_node& current = nodes[id];
+
+  auto unsupported = [&](const std::string& what){
+    Rcpp::stop("Could not evaluate " + algebra + " for each person: " + what +
+      " is not supported in person-specific algebras.");
+  };
+  // returns the root of an algebra or -1 if name is not an algebra
+  auto algebra_root = [&](const std::string& name) -> int {
+    auto found = algebra_roots.find(name);
+    if(found == algebra_roots.end())
+      return(-1);
+    if(found->second < 0)
+      Rcpp::stop("Could not parse the algebra " + name + ".");
+    return(found->second);
+  };
+
+  switch(current.type){
+  case node_type::number:
+    node.type = resolved_type::constant;
+    node.value = std::strtod(current.text.c_str(), nullptr);
+    return;
+  case node_type::symbol:{
+    if(current.text.rfind("data.", 0) == 0){
+      node.type = resolved_type::definition_variable;
+      node.index = definition_variables.emplace(current.text, definition_variables.size()).first->second;
+      return;
+    }
+    auto parameter = input.parameters.find(current.text);
+    if(parameter != input.parameters.end()){
+      node.type = resolved_type::constant;
+      node.value = parameter->second;
+      return;
+    }
+    const int root = algebra_root(current.text);
+    if(root < 0)
+      Rcpp::stop("Could not find " + current.text + " (used in " + algebra + ") in the model.");
+    if((nodes[root].type == node_type::call) &&
+       (nodes[root].text == "cbind" || nodes[root].text == "rbind") &&
+       (nodes[root].children.size() != 1))
+      unsupported("the vector valued algebra " + current.text);
+    resolve(root, current.text, input, algebra_roots, definition_variables);
+    node.type = resolved_type::reference;
+    node.index = static_cast<std::size_t>(root);
+    return;
+  }
+  case node_type::index:{
+    // elements of algebras (e.g., a[1,1] or mxsem_packed_1[1,3])
+    const algebra_node& object = nodes[current.children[0]];
+    const int root = object.type == node_type::symbol ? algebra_root(object.text) : -1;
+    if(root < 0 || current.children.size() != 3)
+      unsupported(node_to_string(nodes, id));
+    std::size_t index[2];
+    for(std::size_t i = 0; i < 2; i++){
+      const algebra_node& position = nodes[current.children[i + 1]];
+      const double value = position.type == node_type::number ?
+      std::strtod(position.text.c_str(), nullptr) : 0.0;
+      if(value < 1.0 || value != std::floor(value))
+        unsupported(node_to_string(nodes, id));
+      index[i] = static_cast<std::size_t>(value) - 1;
+    }
+    const algebra_node& value = nodes[root];
+    int target = root;
+    if((value.type == node_type::call) && (value.text == "cbind") && (index[0] == 0) &&
+       (index[1] < value.children.size())){
+      target = value.children[index[1]];
+    }else if((value.type == node_type::call) && (value.text == "rbind") && (index[1] == 0) &&
+      (index[0] < value.children.size())){
+      target = value.children[index[0]];
+    }else if((index[0] != 0) || (index[1] != 0) ||
+      ((value.type == node_type::call) && (value.text == "cbind" || value.text == "rbind") &&
+      (value.children.size() != 1))){
+      unsupported(node_to_string(nodes, id));
+    }
+    resolve(target, object.text, input, algebra_roots, definition_variables);
+    node.type = resolved_type::reference;
+    node.index = static_cast<std::size_t>(target);
+    return;
+  }
+  case node_type::unary:
+    if(current.text != "-" && current.text != "+")
+      unsupported("the operator " + current.text);
+    node.type = resolved_type::unary;
+    node.op = current.text[0];
+    break;
+  case node_type::binary:
+    if(current.text == "%*%"){
+      // same as * for 1x1 matrices
+      node.op = '*';
+    }else if(current.text == "+" || current.text == "-" || current.text == "*" ||
+      current.text == "/" || current.text == "^"){
+      node.op = current.text[0];
+    }else{
+      unsupported("the operator " + current.text);
+    }
+    node.type = resolved_type::binary;
+    break;
+  case node_type::call:
+    if((current.text == "cbind" || current.text == "rbind" || current.text == "c") &&
+       (current.children.size() == 1)){
+      // a 1x1 matrix; the same as its element
+      resolve(current.children[0], algebra, input, algebra_roots, definition_variables);
+      node.type = resolved_type::reference;
+      node.index = static_cast<std::size_t>(current.children[0]);
+      return;
+    }
+    node.function = find_function(current.text);
+    if(node.function == nullptr || current.children.size() != 1)
+      unsupported("the function " + current.text);
+    node.type = resolved_type::call;
+    break;
+  }
+
+  for(const int child: current.children)
+    resolve(child, algebra, input, algebra_roots, definition_variables);
+}
+
+double person_model::evaluate(const int id, const std::size_t row) const{
+  const resolved_node& node = resolved[id];
+  switch(node.type){
+  case resolved_type::constant:
+    return(node.value);
+  case resolved_type::definition_variable:
+    return(definition_values[node.index][row]);
+  case resolved_type::reference:
+    return(evaluate(static_cast<int>(node.index), row));
+  case resolved_type::unary:{
+    const double value = evaluate(nodes[id].children[0], row);
+    return(node.op == '-' ? -value : value);
+  }
+  case resolved_type::binary:{
+    const double lhs = evaluate(nodes[id].children[0], row);
+    const double rhs = evaluate(nodes[id].children[1], row);
+    switch(node.op){
+    case '+':
+      return(lhs + rhs);
+    case '-':
+      return(lhs - rhs);
+    case '*':
+      return(lhs * rhs);
+    case '/':
+      return(lhs / rhs);
+    default:
+      return(std::pow(lhs, rhs));
+    }
+  }
+  case resolved_type::call:
+    return(node.function(evaluate(nodes[id].children[0], row)));
+  case resolved_type::unresolved:
+    break;
+  }
+  return(NAN);
+}
+
+void person_model::set_elements(std::size_t row,
+                                dense_matrix& a,
+                                dense_matrix& s,
+                                std::vector<double>& m) const{
+  for(const element& e: elements){
+    const double value = evaluate(e.root, row);
+    switch(e.matrix){
+    case 'A':
+      a(e.row, e.col) = value;
+      break;
+    case 'S':
+      s(e.row, e.col) = value;
+      break;
+    default:
+      m[e.col] = value;
+      break;
+    }
+  }
+}
+
+bool person_model::same_definition_values(std::size_t row_1, std::size_t row_2) const{
+  for(const std::vector<double>& values: definition_values){
+    if(compare_values(values[row_1], values[row_2]) != 0)
+      return(false);
+  }
+  return(true);
+}
+
+std::vector<std::size_t> person_model::row_order() const{
+  std::vector<std::size_t> order(n_rows);
+  std::iota(order.begin(), order.end(), 0);
+  if(definition_values.empty() && manifests.empty())
+    return(order);
+  std::sort(order.begin(), order.end(),
+            [&](const std::size_t a, const std::size_t b){
+              for(const std::vector<double>& values: definition_values){
+                const int comparison = compare_values(values[a], values[b]);
+                if(comparison != 0)
+                  return(comparison < 0);
+              }
+              if(missingness[a] != missingness[b])
+                return(missingness[a] < missingness[b]);
+              return(a < b);
+            });
+  return(order);
+}
+
+person_moments::person_moments(const person_model& model):
+  covariance(model.A.n_rows, model.A.n_rows),
+  mean(model.A.n_rows, 0.0),
+  model(model),
+  A(model.A),
+  S(model.S),
+  M(model.M){
+  if(!model.A_is_person_specific)
+    compute_B();
+}
+
+void person_moments::compute_B(){
+  const std::size_t n = A.n_rows;
+  B = dense_matrix(n, n);
+  for(std::size_t i = 0; i < n * n; i++)
+    B.values[i] = -A.values[i];
+  for(std::size_t i = 0; i < n; i++)
+    B(i, i) += 1.0;
+  if(!invert(B))
+    std::fill(B.values.begin(), B.values.end(), NAN);
+}
+
+bool person_moments::set_row(const std::size_t new_row){
+  if(has_row && model.same_definition_values(row, new_row))
+    return(false);
+  has_row = true;
+  row = new_row;
+
+  model.set_elements(row, A, S, M);
+  if(model.A_is_person_specific)
+    compute_B();
+
+  // covariance = B S B^T; mean = B M
+  const std::size_t n = A.n_rows;
+  dense_matrix BS(n, n);
+  for(std::size_t j = 0; j < n; j++){
+    for(std::size_t k = 0; k < n; k++){
+      const double s = S(k, j);
+      if(s == 0.0)
+        continue;
+      for(std::size_t i = 0; i < n; i++)
+        BS(i, j) += B(i, k) * s;
+    }
+  }
+  for(std::size_t j = 0; j < n; j++){
+    for(std::size_t i = j; i < n; i++){
+      double value = 0.0;
+      for(std::size_t k = 0; k < n; k++)
+        value += BS(i, k) * B(j, k);
+      covariance(i, j) = value;
+      covariance(j, i) = value;
+    }
+    double value = 0.0;
+    for(std::size_t k = 0; k < n; k++)
+      value += B(j, k) * M[k];
+    mean[j] = value;
+  }
+  return(true);
+}
+
+void for_each_chunk_parallel(const std::size_t n,
+                             const std::size_t n_threads,
+                             const std::function<void(std::size_t, std::size_t)>& process){
+  const std::size_t n_chunks = std::max<std::size_t>(1, std::min(std::max<std::size_t>(n_threads, 1),
+                                                                 n / min_rows_per_chunk));
+  std::vector<std::string> errors(n_chunks);
+
+  auto process_chunk = [&](std::size_t c){
+    try{
+      process(c * n / n_chunks, (c + 1) * n / n_chunks);
+    }catch(const std::exception& e){
+      errors.at(c) = e.what();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for(std::size_t c = 1; c < n_chunks; c++)
+    workers.emplace_back(process_chunk, c);
+  process_chunk(0);
+  for(std::thread& worker: workers)
+    worker.join();
+
+  for(const std::string& error: errors){
+    if(!error.empty())
+      Rcpp::stop(error);
+  }
+}
+
+person_model_input read_person_model(Rcpp::List model, Rcpp::List data){
+  person_model_input input;
+
+  input.variables = Rcpp::as<std::vector<std::string>>(model["variables"]);
+  input.A = Rcpp::as<std::vector<double>>(model["A"]);
+  input.S = Rcpp::as<std::vector<double>>(model["S"]);
+  input.M = Rcpp::as<std::vector<double>>(model["M"]);
+  input.manifests = Rcpp::as<std::vector<std::string>>(model["manifests"]);
+
+  Rcpp::List elements = model["elements"];
+  input.element_matrix = Rcpp::as<std::vector<std::string>>(elements["matrix"]);
+  input.element_label = Rcpp::as<std::vector<std::string>>(elements["label"]);
+  for(const int row: Rcpp::as<std::vector<int>>(elements["row"]))
+    input.element_row.push_back(static_cast<std::size_t>(row - 1));
+  for(const int col: Rcpp::as<std::vector<int>>(elements["col"]))
+    input.element_col.push_back(static_cast<std::size_t>(col - 1));
+
+  Rcpp::List algebras = model["algebras"];
+  input.algebra_names = Rcpp::as<std::vector<std::string>>(algebras["name"]);
+  input.algebra_formulas = Rcpp::as<std::vector<std::string>>(algebras["formula"]);
+
+  Rcpp::NumericVector parameters = Rcpp::as<Rcpp::NumericVector>(model["parameters"]);
+  if(parameters.size() > 0){
+    const std::vector<std::string> labels = Rcpp::as<std::vector<std::string>>(parameters.names());
+    for(R_xlen_t p = 0; p < parameters.size(); p++)
+      input.parameters[labels[p]] = parameters[p];
+  }
+
+  input.n_rows = data.size() == 0 ? 0 : Rf_xlength(VECTOR_ELT(data, 0));
+  input.read_column = [data](const std::string& name){
+    return(read_numeric_column(data, name));
+  };
+  return(input);
+}
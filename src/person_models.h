@@ -0,0 +1,163 @@
+#ifndef PERSON_MODELS_H
+#define PERSON_MODELS_H
+#include <Rcpp.h>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "algebra_parser.h"
+
+// Dense column-major matrix. The matrices of a RAM model are small, so the
+// few decompositions needed for person-level results are implemented here
+// instead of linking to a linear algebra library.
+struct dense_matrix{
+  std::size_t n_rows = 0;
+  std::size_t n_cols = 0;
+  std::vector<double> values;
+
+  dense_matrix() = default;
+  dense_matrix(std::size_t n_rows, std::size_t n_cols):
+  n_rows(n_rows), n_cols(n_cols), values(n_rows * n_cols, 0.0){}
+
+  double& operator()(std::size_t row, std::size_t col){
+    return(values[col * n_rows + row]);
+  }
+  double operator()(std::size_t row, std::size_t col) const{
+    return(values[col * n_rows + row]);
+  }
+};
+
+// replaces m with its lower Cholesky factor L (m = L L^T). Returns false if m
+// is not positive definite.
+bool cholesky(dense_matrix& m);
+// solves L L^T X = b; b is replaced with X
+void cholesky_solve(const dense_matrix& l, dense_matrix& b);
+// log determinant of L L^T
+double cholesky_log_determinant(const dense_matrix& l);
+// replaces m with its inverse (Gauss-Jordan elimination with partial
+// pivoting). Returns false if m is singular.
+bool invert(dense_matrix& m);
+
+// Everything needed to set up a person_model. Columns of the data are only
+// read through read_column, which is called on the main thread while the
+// model is created.
+struct person_model_input{
+  // names of all variables (rows and columns of A and S)
+  std::vector<std::string> variables;
+  std::vector<std::string> manifests;
+  // values of the fitted model (column-major; M is a vector)
+  std::vector<double> A, S, M;
+  // elements of A, S, and M that depend on definition variables. The label is
+  // the label of the element in the mxModel (e.g., data.k or a[1,1])
+  std::vector<std::string> element_matrix;
+  std::vector<std::size_t> element_row, element_col;
+  std::vector<std::string> element_label;
+  // algebras that the labels may refer to
+  std::vector<std::string> algebra_names, algebra_formulas;
+  std::unordered_map<std::string, double> parameters;
+  std::size_t n_rows = 0;
+  std::function<std::vector<double>(const std::string&)> read_column;
+};
+
+// A RAM model (see mxModel(type = "RAM")) together with its raw data. The
+// elements that depend on definition variables are evaluated for each person
+// from the algebras of the model; all other elements keep the values of the
+// fitted model. The model is read-only after construction and can be shared
+// by multiple threads.
+class person_model{
+public:
+  explicit person_model(const person_model_input& input);
+
+  std::size_t n_rows;
+  std::vector<std::string> latent_names;
+  std::vector<std::size_t> manifests;
+  std::vector<std::size_t> latents;
+  dense_matrix A, S;
+  std::vector<double> M;
+  bool A_is_person_specific = false;
+
+  // raw data of the manifest variables; one vector per manifest
+  std::vector<std::vector<double>> observed;
+
+  // applies the person-specific elements of a row to the matrices
+  void set_elements(std::size_t row, dense_matrix& a, dense_matrix& s, std::vector<double>& m) const;
+
+  bool same_definition_values(std::size_t row_1, std::size_t row_2) const;
+  bool same_missingness(std::size_t row_1, std::size_t row_2) const{
+    return(missingness[row_1] == missingness[row_2]);
+  }
+  // order of the rows (0-based) in which rows with the same values on the
+  // definition variables and the same missingness pattern are contiguous
+  std::vector<std::size_t> row_order() const;
+
+private:
+  enum class resolved_type{unresolved, constant, definition_variable, reference, unary, binary, call};
+  struct resolved_node{
+    resolved_type type = resolved_type::unresolved;
+    double value = 0.0;
+    // definition variable or referenced node
+    std::size_t index = 0;
+    char op = '\0';
+    double (*function)(double) = nullptr;
+  };
+  struct element{
+    char matrix;
+    std::size_t row, col;
+    int root;
+  };
+
+  std::vector<algebra_node> nodes;
+  std::vector<resolved_node> resolved;
+  std::vector<element> elements;
+  std::vector<std::vector<double>> definition_values;
+  // missingness pattern of each row
+  std::vector<std::size_t> missingness;
+
+  void resolve(const int id,
+               const std::string& algebra,
+               const person_model_input& input,
+               const std::unordered_map<std::string, int>& algebra_roots,
+               std::unordered_map<std::string, std::size_t>& definition_variables);
+  double evaluate(const int id, const std::size_t row) const;
+};
+
+// Implied means and covariances of all variables for one person at a time.
+// The moments are only recomputed if the definition variables differ from the
+// previous person.
+class person_moments{
+public:
+  explicit person_moments(const person_model& model);
+
+  // returns true if the moments changed
+  bool set_row(const std::size_t row);
+
+  dense_matrix covariance;
+  std::vector<double> mean;
+
+private:
+  const person_model& model;
+  dense_matrix A, S;
+  std::vector<double> M;
+  // (I-A)^-1; only recomputed if A depends on definition variables
+  dense_matrix B;
+  bool has_row = false;
+  std::size_t row = 0;
+
+  void compute_B();
+};
+
+// rows of the data are processed in chunks on separate threads. Chunks have at
+// least min_rows_per_chunk rows.
+static constexpr std::size_t min_rows_per_chunk = 1024;
+// calls process(first, last) for chunks of [0, n) on up to n_threads threads.
+// process must not call R.
+void for_each_chunk_parallel(const std::size_t n,
+                             const std::size_t n_threads,
+                             const std::function<void(std::size_t, std::size_t)>& process);
+
+// creates the input of a person_model from the list created by
+// prepare_person_model (see R/person_models.R) and the raw data. Must be
+// called on the main thread.
+person_model_input read_person_model(Rcpp::List model, Rcpp::List data);
+
+#endif
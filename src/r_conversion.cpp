@@ -0,0 +1,194 @@
+#include "r_conversion.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+SEXP r_string_cache::get(std::string_view str){
+  auto known = cache.find(str);
+  if(known != cache.end())
+    return(known->second);
+
+  SEXP r_str = Rf_mkCharLenCE(str.data(), str.size(), CE_UTF8);
+  cache.emplace(str, r_str);
+  return(r_str);
+}
+
+std::vector<std::size_t> all_rows(const std::size_t n_rows){
+  std::vector<std::size_t> rows(n_rows);
+  std::iota(rows.begin(), rows.end(), 0);
+  return(rows);
+}
+
+Rcpp::CharacterVector column_to_r(const pt_column& column,
+                                  const std::vector<std::size_t>& rows,
+                                  r_string_cache& cache){
+  Rcpp::CharacterVector r_column(rows.size());
+  for(unsigned int i = 0; i < rows.size(); i++){
+    SET_STRING_ELT(r_column, i, cache.get(column.at(rows.at(i))));
+  }
+  return(r_column);
+}
+
+Rcpp::IntegerVector column_to_factor(const pt_column& column,
+                                     const std::vector<std::size_t>& rows,
+                                     const Rcpp::CharacterVector& levels){
+  Rcpp::IntegerVector r_column(rows.size());
+
+  for(unsigned int i = 0; i < rows.size(); i++){
+    const pt_string& element = column.at(rows.at(i));
+    bool was_found = false;
+    for(R_xlen_t l = 0; l < levels.size(); l++){
+      if(element.compare(CHAR(STRING_ELT(levels, l))) == 0){
+        // factor levels start at 1
+        r_column[i] = l + 1;
+        was_found = true;
+        break;
+      }
+    }
+    if(!was_found)
+      Rcpp::stop("Could not find " + std::string(element) + " in the factor levels.");
+  }
+
+  r_column.attr("levels") = levels;
+  r_column.attr("class") = "factor";
+  return(r_column);
+}
+
+Rcpp::LogicalVector column_to_logical(const pt_column& column,
+                                      const std::vector<std::size_t>& rows){
+  Rcpp::LogicalVector r_column(rows.size());
+  for(unsigned int i = 0; i < rows.size(); i++){
+    const pt_string& element = column.at(rows.at(i));
+    if(element.compare("TRUE") == 0){
+      r_column[i] = TRUE;
+    }else if(element.compare("FALSE") == 0){
+      r_column[i] = FALSE;
+    }else{
+      r_column[i] = NA_LOGICAL;
+    }
+  }
+  return(r_column);
+}
+
+Rcpp::List make_data_frame(const Rcpp::List& columns,
+                           const Rcpp::CharacterVector& column_names,
+                           const R_xlen_t n_rows){
+  // we set the attributes of the data.frame directly instead of using
+  // Rcpp::DataFrame::create, which checks and copies all columns.
+  Rcpp::List data_frame(columns);
+  data_frame.attr("names") = column_names;
+  // compact row names: c(NA, -n_rows)
+  data_frame.attr("row.names") = Rcpp::IntegerVector::create(NA_INTEGER, -n_rows);
+  data_frame.attr("class") = "data.frame";
+  return(data_frame);
+}
+
+Rcpp::List parameter_table_columns_to_r(const parameter_table& pt,
+                                        const std::vector<std::string>& columns,
+                                        const std::vector<std::size_t>& rows,
+                                        r_string_cache& cache){
+
+  for(std::size_t row: rows){
+    if(row >= pt.lhs.size())
+      Rcpp::stop("Row " + std::to_string(row + 1) + " does not exist. The parameter table has " +
+        std::to_string(pt.lhs.size()) + " rows.");
+  }
+
+  Rcpp::List r_columns(columns.size());
+  Rcpp::CharacterVector column_names(columns.size());
+
+  for(unsigned int i = 0; i < columns.size(); i++){
+    const std::string& column = columns.at(i);
+    column_names[i] = column;
+
+    if(column.compare("lhs") == 0){
+      r_columns[i] = column_to_r(pt.lhs, rows, cache);
+    }else if(column.compare("op") == 0){
+      r_columns[i] = column_to_factor(pt.op, rows, Rcpp::CharacterVector::create("=~", "~~", "~"));
+    }else if(column.compare("rhs") == 0){
+      r_columns[i] = column_to_r(pt.rhs, rows, cache);
+    }else if(column.compare("modifier") == 0){
+      r_columns[i] = column_to_r(pt.modifier, rows, cache);
+    }else if(column.compare("lbound") == 0){
+      r_columns[i] = column_to_r(pt.lbound, rows, cache);
+    }else if(column.compare("ubound") == 0){
+      r_columns[i] = column_to_r(pt.ubound, rows, cache);
+    }else if(column.compare("free") == 0){
+      r_columns[i] = column_to_logical(pt.free, rows);
+    }else{
+      Rcpp::stop("Unknown column " + column + ". The parameter table has the columns " +
+        "lhs, op, rhs, modifier, lbound, ubound, and free.");
+    }
+  }
+
+  return(make_data_frame(r_columns, column_names, rows.size()));
+}
+
+Rcpp::List parameter_table_to_r(const parameter_table& pt){
+
+  r_string_cache cache(pt.resource());
+
+  Rcpp::List pt_Rcpp = parameter_table_columns_to_r(
+    pt,
+    {"lhs", "op", "rhs", "modifier", "lbound", "ubound", "free"},
+    all_rows(pt.lhs.size()),
+    cache);
+
+  const std::vector<std::size_t> algebra_rows = all_rows(pt.alg.lhs.size());
+  Rcpp::List pt_algebras = make_data_frame(
+    Rcpp::List::create(column_to_r(pt.alg.lhs, algebra_rows, cache),
+                       column_to_r(pt.alg.op, algebra_rows, cache),
+                       column_to_r(pt.alg.rhs, algebra_rows, cache)),
+    Rcpp::CharacterVector::create("lhs", "op", "rhs"),
+    algebra_rows.size());
+
+  Rcpp::List pt_variables = Rcpp::List::create(
+    Rcpp::Named("manifests") = column_to_r(pt.vars.manifests, all_rows(pt.vars.manifests.size()), cache),
+    Rcpp::Named("latents") = column_to_r(pt.vars.latents, all_rows(pt.vars.latents.size()), cache));
+
+  const std::vector<std::size_t> new_parameter_rows = all_rows(pt.alg.new_parameters.size());
+  Rcpp::List combined = Rcpp::List::create(
+    Rcpp::Named("parameter_table") = pt_Rcpp,
+    Rcpp::Named("user_defined") = column_to_r(pt.user_defined, all_rows(pt.user_defined.size()), cache),
+    Rcpp::Named("algebras") = pt_algebras,
+    Rcpp::Named("variables") = pt_variables,
+    Rcpp::Named("new_parameters") = column_to_r(pt.alg.new_parameters, new_parameter_rows, cache),
+    Rcpp::Named("new_parameters_free") = column_to_r(pt.alg.new_parameters_free, new_parameter_rows, cache)
+  );
+
+  return(combined);
+}
+
+std::vector<double> read_numeric_column(const Rcpp::List& data, const std::string& name){
+  const Rcpp::CharacterVector data_names(data.names());
+  SEXP column = R_NilValue;
+  for(R_xlen_t i = 0; i < data_names.size(); i++){
+    if(name.compare(CHAR(STRING_ELT(data_names, i))) == 0){
+      column = VECTOR_ELT(data, i);
+      break;
+    }
+  }
+  if(column == R_NilValue)
+    Rcpp::stop("Could not find the variable " + name + " in the data.");
+  // factors are integer vectors, but their level codes are not values
+  if(Rf_isFactor(column))
+    Rcpp::stop("The variable " + name + " is a factor. Convert it to a numeric variable first.");
+
+  const std::size_t n = Rf_xlength(column);
+  std::vector<double> values(n);
+  switch(TYPEOF(column)){
+  case REALSXP:
+    std::copy(REAL(column), REAL(column) + n, values.begin());
+    break;
+  case INTSXP:
+  case LGLSXP:{
+    const int* integers = TYPEOF(column) == INTSXP ? INTEGER(column) : LOGICAL(column);
+    for(std::size_t i = 0; i < n; i++)
+      values[i] = integers[i] == NA_INTEGER ? NAN : integers[i];
+    break;
+  }
+  default:
+    Rcpp::stop("The variable " + name + " must be numeric.");
+  }
+  return(values);
+}
@@ -0,0 +1,54 @@
+#ifndef R_CONVERSION_H
+#define R_CONVERSION_H
+#include <Rcpp.h>
+#include <string_view>
+#include <unordered_map>
+#include "parameter_table.h"
+
+// Most cells of a parameter table are repetitions of a few variable names,
+// operators, and empty strings. r_string_cache creates each distinct string
+// only once in R's global string cache and reuses it for all further
+// occurrences. The strings are only protected by the vectors they are written
+// to; the cache must therefore not outlive these vectors.
+class r_string_cache{
+public:
+  explicit r_string_cache(std::pmr::memory_resource* mr = std::pmr::get_default_resource()):
+  cache(mr){}
+
+  SEXP get(std::string_view str);
+
+private:
+  std::pmr::unordered_map<std::string_view, SEXP> cache;
+};
+
+// The conversion functions only copy the elements of a column that are
+// listed in rows (0-based). all_rows creates the indices for a full column.
+std::vector<std::size_t> all_rows(const std::size_t n_rows);
+
+Rcpp::CharacterVector column_to_r(const pt_column& column,
+                                  const std::vector<std::size_t>& rows,
+                                  r_string_cache& cache);
+
+Rcpp::IntegerVector column_to_factor(const pt_column& column,
+                                     const std::vector<std::size_t>& rows,
+                                     const Rcpp::CharacterVector& levels);
+
+Rcpp::LogicalVector column_to_logical(const pt_column& column,
+                                      const std::vector<std::size_t>& rows);
+
+Rcpp::List make_data_frame(const Rcpp::List& columns,
+                           const Rcpp::CharacterVector& column_names,
+                           const R_xlen_t n_rows);
+
+Rcpp::List parameter_table_columns_to_r(const parameter_table& pt,
+                                        const std::vector<std::string>& columns,
+                                        const std::vector<std::size_t>& rows,
+                                        r_string_cache& cache);
+
+Rcpp::List parameter_table_to_r(const parameter_table& pt);
+
+// returns the column name of a data.frame as double. Missing values
+// (including NA in integer columns) are NaN. Factors are rejected.
+std::vector<double> read_numeric_column(const Rcpp::List& data, const std::string& name);
+
+#endif
@@ -0,0 +1,129 @@
+#include <Rcpp.h>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// The directed paths of a RAM model (loadings and regressions) form a graph.
+// If this graph has no cycles (recursive model), the variables can be ordered
+// such that every path points from an earlier to a later variable. The A
+// matrix is then strictly triangular and (I-A)^-1 = I + A + ... + A^depth,
+// where depth is the length of the longest directed path.
+
+struct ram_structure{
+  // variables in topological order; empty if the model is not recursive
+  std::vector<std::size_t> order;
+  // number of paths on the longest directed path
+  std::size_t depth = 0;
+  bool is_recursive = true;
+  // variables on directed cycles (non-recursive models)
+  std::vector<std::size_t> cyclic;
+};
+
+// finds the topological order with Kahn's algorithm. Among the variables
+// without remaining predecessors, the one that comes first in variables is
+// taken next, so the order only changes where the paths require it.
+static ram_structure find_ram_structure(const std::vector<std::vector<std::size_t>>& successors){
+  const std::size_t n_variables = successors.size();
+  ram_structure structure;
+
+  std::vector<std::size_t> n_predecessors(n_variables, 0);
+  for(const std::vector<std::size_t>& targets: successors){
+    for(const std::size_t target: targets)
+      n_predecessors[target]++;
+  }
+
+  std::priority_queue<std::size_t, std::vector<std::size_t>, std::greater<std::size_t>> ready;
+  for(std::size_t v = 0; v < n_variables; v++){
+    if(n_predecessors[v] == 0)
+      ready.push(v);
+  }
+
+  // longest directed path that ends in each variable
+  std::vector<std::size_t> path_length(n_variables, 0);
+  while(!ready.empty()){
+    const std::size_t v = ready.top();
+    ready.pop();
+    structure.order.push_back(v);
+    for(const std::size_t target: successors[v]){
+      path_length[target] = std::max(path_length[target], path_length[v] + 1);
+      structure.depth = std::max(structure.depth, path_length[target]);
+      if(--n_predecessors[target] == 0)
+        ready.push(target);
+    }
+  }
+
+  if(structure.order.size() < n_variables){
+    // all variables that were not ordered are on a cycle or depend on one
+    structure.is_recursive = false;
+    for(std::size_t v = 0; v < n_variables; v++){
+      if(n_predecessors[v] > 0)
+        structure.cyclic.push_back(v);
+    }
+    structure.order.clear();
+    structure.depth = 0;
+  }
+  return(structure);
+}
+
+//' ram_structure_rcpp
+//'
+//' analyzes the directed paths (loadings and regressions) of a parameter table. For
+//' recursive models, the variables are returned in topological order (each path
+//' points from an earlier to a later variable) together with the length of the longest
+//' directed path. Paths with fixed values (including 0) are treated as paths.
+//' @param lhs left hand side of the parameter table
+//' @param op operators of the parameter table
+//' @param rhs right hand side of the parameter table
+//' @param variables names of all variables. Variables without directed paths keep
+//' their position relative to each other.
+//' @return list with is_recursive, the variables in topological order (order; empty if the
+//' model is not recursive), the length of the longest directed path (depth; NA if the
+//' model is not recursive), and the variables on or after a directed cycle (cyclic)
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::List ram_structure_rcpp(const std::vector<std::string>& lhs,
+                              const std::vector<std::string>& op,
+                              const std::vector<std::string>& rhs,
+                              const std::vector<std::string>& variables){
+  std::unordered_map<std::string, std::size_t> index;
+  for(std::size_t v = 0; v < variables.size(); v++)
+    index.emplace(variables.at(v), v);
+
+  std::vector<std::vector<std::size_t>> successors(variables.size());
+  for(std::size_t i = 0; i < lhs.size(); i++){
+    std::string from, to;
+    if(op.at(i).compare("=~") == 0){
+      from = lhs.at(i);
+      to = rhs.at(i);
+    }else if((op.at(i).compare("~") == 0) && (rhs.at(i).compare("1") != 0)){
+      from = rhs.at(i);
+      to = lhs.at(i);
+    }else{
+      continue;
+    }
+    auto from_index = index.find(from);
+    auto to_index = index.find(to);
+    if((from_index == index.end()) || (to_index == index.end()))
+      Rcpp::stop("Could not find the variables of the path " + from + " -> " + to + ".");
+    successors.at(from_index->second).push_back(to_index->second);
+  }
+
+  const ram_structure structure = find_ram_structure(successors);
+
+  auto names = [&](const std::vector<std::size_t>& indices){
+    Rcpp::CharacterVector result(indices.size());
+    for(std::size_t i = 0; i < indices.size(); i++)
+      result[i] = variables.at(indices.at(i));
+    return(result);
+  };
+
+  return(Rcpp::List::create(Rcpp::Named("is_recursive") = structure.is_recursive,
+                            Rcpp::Named("order") = names(structure.order),
+                            Rcpp::Named("depth") = structure.is_recursive ?
+                              static_cast<int>(structure.depth) :
+                              NA_INTEGER,
+                            Rcpp::Named("cyclic") = names(structure.cyclic)));
+}
@@ -1,10 +1,11 @@
 #include "scale_latent_variables.h"
 #include "string_operations.h"
+#include "diagnostics.h"
 
 void scale_latent_variances(parameter_table& pt){
-  std::vector<std::string> latents = pt.vars.latents;
+  const pt_column& latents = pt.vars.latents;
 
-  for(std::string& latent: latents){
+  for(const pt_string& latent: latents){
 
     for(unsigned int i = 0; i < pt.lhs.size(); i++){
 
@@ -20,11 +21,10 @@ void scale_latent_variances(parameter_table& pt){
           break;
         }else if(is_number(pt.modifier.at(i))){
           // is fixed
-          Rcpp::Function message("message");
-          message("Skipping the automatic scaling by constraining the variance of " + latent +
+          parse_message("Skipping the automatic scaling by constraining the variance of " + std::string(latent) +
             ". The variable's variance was already scaled manually (e.g., eta ~~ 1*eta).");
         }else{
-          Rcpp::warning("Automatic scaling by constraining the variance of " + latent +
+          parse_warning("Automatic scaling by constraining the variance of " + std::string(latent) +
             " failed because a label was assigned to the variance (e.g., eta ~~ var*eta).");
         }
       }
@@ -33,8 +33,8 @@ void scale_latent_variances(parameter_table& pt){
 }
 
 void scale_loadings(parameter_table& pt){
-  std::vector<std::string> latents = pt.vars.latents;
-  for(std::string& latent: latents){
+  const pt_column& latents = pt.vars.latents;
+  for(const pt_string& latent: latents){
 
     bool was_scaled = false; // set to true if the latent variable was already
     // scaled manually by the user
@@ -64,14 +64,13 @@ void scale_loadings(parameter_table& pt){
     }
 
     if(was_scaled){
-      Rcpp::Function message("message");
-      message("Skipping the automatic scaling of " + latent +
+      parse_message("Skipping the automatic scaling of " + std::string(latent) +
         ". The variable was already scaled manually (e.g., eta =~ 1*y1 + ...).");
     }
     if((!was_scaled) && (scale_location != -1))
       pt.modifier.at(scale_location) = "1.0";
     if((!was_scaled) && (scale_location == -1))
-      Rcpp::warning("Automatically scaling latent variable " + latent +
+      parse_warning("Automatically scaling latent variable " + std::string(latent) +
         " failed. Could not find an unlabeled free loading on observed items." +
         " Did you give labels to all loadings? If so, remove the label for one of the items or manually" +
         " set one of the loadings to a fixed value (e.g., eta =~ 1*y1 + ...).");
@@ -0,0 +1,53 @@
+#include "scan.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MXSEM_SCAN_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MXSEM_SCAN_SSE2
+#endif
+
+std::size_t byte_set::find(std::string_view str, std::size_t from) const{
+
+  const char* data = str.data();
+  const std::size_t size = str.size();
+  std::size_t i = from;
+
+#if defined(MXSEM_SCAN_AVX2)
+  __m256i needles[16];
+  for(std::size_t b = 0; b < n_bytes; b++)
+    needles[b] = _mm256_set1_epi8(bytes[b]);
+
+  for(; i + 32 <= size; i += 32){
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    __m256i hits = _mm256_setzero_si256();
+    for(std::size_t b = 0; b < n_bytes; b++)
+      hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, needles[b]));
+    const unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(hits));
+    if(mask != 0)
+      return(i + __builtin_ctz(mask));
+  }
+#elif defined(MXSEM_SCAN_SSE2)
+  __m128i needles[16];
+  for(std::size_t b = 0; b < n_bytes; b++)
+    needles[b] = _mm_set1_epi8(bytes[b]);
+
+  for(; i + 16 <= size; i += 16){
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    __m128i hits = _mm_setzero_si128();
+    for(std::size_t b = 0; b < n_bytes; b++)
+      hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, needles[b]));
+    const unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(hits));
+    if(mask != 0)
+      return(i + __builtin_ctz(mask));
+  }
+#endif
+
+  // remaining characters (and all characters without SIMD support)
+  for(; i < size; i++){
+    if(contains(data[i]))
+      return(i);
+  }
+  return(size);
+}
@@ -0,0 +1,133 @@
+#ifndef SCAN_H
+#define SCAN_H
+#include <Rcpp.h>
+#include <array>
+#include <stdexcept>
+#include <string_view>
+
+// Shared scanning kernel for all passes that walk the syntax character by
+// character. Characters are classified with a constexpr lookup table and
+// searches for small sets of delimiters are done 16 (SSE2) or 32 (AVX2)
+// bytes at a time, with a scalar fallback on other platforms.
+
+// character classes; a character can be in multiple classes
+enum char_class: unsigned char{
+  cc_letter      = 1 << 0, // a-z, A-Z
+  cc_digit       = 1 << 1, // 0-9
+  cc_whitespace  = 1 << 2, // space and tab. New lines end an equation
+  cc_line_end    = 1 << 3, // \n and ;
+  cc_comment     = 1 << 4, // #
+  cc_curly       = 1 << 5, // { and }
+  cc_operator    = 1 << 6, // +*=~: - an equation continues after these
+  cc_equation    = 1 << 7  // _=~*+-. - special characters allowed in equations
+};
+
+constexpr std::array<unsigned char, 256> make_char_classes(){
+  std::array<unsigned char, 256> classes{};
+  for(int c = 'a'; c <= 'z'; c++)
+    classes[c] |= cc_letter;
+  for(int c = 'A'; c <= 'Z'; c++)
+    classes[c] |= cc_letter;
+  for(int c = '0'; c <= '9'; c++)
+    classes[c] |= cc_digit;
+  classes[' ']  |= cc_whitespace;
+  classes['\t'] |= cc_whitespace;
+  classes['\n'] |= cc_line_end;
+  classes[';']  |= cc_line_end;
+  classes['#']  |= cc_comment;
+  classes['{']  |= cc_curly;
+  classes['}']  |= cc_curly;
+  for(char c: std::string_view("+*=~:"))
+    classes[static_cast<unsigned char>(c)] |= cc_operator;
+  for(char c: std::string_view("_=~*+-."))
+    classes[static_cast<unsigned char>(c)] |= cc_equation;
+  return(classes);
+}
+
+inline constexpr std::array<unsigned char, 256> char_classes = make_char_classes();
+
+inline bool is_char_class(const char c, const unsigned char classes){
+  return((char_classes[static_cast<unsigned char>(c)] & classes) != 0);
+}
+
+// A small set of characters (at most 16) that can be searched for in bulk.
+class byte_set{
+public:
+  explicit byte_set(std::string_view chars){
+    add(chars);
+  }
+
+  void add(std::string_view chars){
+    if(n_bytes + chars.size() > bytes.size())
+      throw std::length_error("byte_set can hold at most 16 characters.");
+    for(char c: chars)
+      bytes[n_bytes++] = c;
+  }
+
+  bool contains(const char c) const{
+    for(std::size_t i = 0; i < n_bytes; i++){
+      if(bytes[i] == c)
+        return(true);
+    }
+    return(false);
+  }
+
+  // returns the position of the first character in str (starting at from)
+  // that is in the set or str.size() if there is none.
+  std::size_t find(std::string_view str, std::size_t from = 0) const;
+
+private:
+  std::array<char, 16> bytes{};
+  std::size_t n_bytes = 0;
+};
+
+// Calls on_segment(start, end) for each part of str that is not inside curly
+// braces. The braces themselves are not part of any segment. on_segment
+// returns false to stop the scan. Returns the position of the first closing
+// brace without an opening brace or std::string_view::npos if there is none;
+// the scan stops at this brace.
+template<class F>
+std::size_t for_each_top_level_segment(std::string_view str, F&& on_segment){
+  static const byte_set curly("{}");
+
+  int n_curly_open = 0;
+  std::size_t segment_start = 0;
+  for(std::size_t i = curly.find(str); i < str.size(); i = curly.find(str, i + 1)){
+    if(str[i] == '{'){
+      if((n_curly_open == 0) && (i > segment_start) && !on_segment(segment_start, i))
+        return(std::string_view::npos);
+      n_curly_open++;
+    }else{
+      if(n_curly_open == 0){
+        // everything up to the unmatched brace is still checked
+        if((i > segment_start) && !on_segment(segment_start, i))
+          return(std::string_view::npos);
+        return(i);
+      }
+      n_curly_open--;
+      if(n_curly_open == 0)
+        segment_start = i + 1;
+    }
+  }
+  if((n_curly_open == 0) && (segment_start < str.size()))
+    on_segment(segment_start, str.size());
+  return(std::string_view::npos);
+}
+
+// Calls on_match(position) for each character of str that is in delimiters
+// and not inside curly braces. on_match returns false to stop the scan.
+// Returns the position of the first closing brace without an opening brace
+// (see for_each_top_level_segment).
+template<class F>
+std::size_t for_each_top_level(std::string_view str, const byte_set& delimiters, F&& on_match){
+  return(for_each_top_level_segment(str, [&](std::size_t start, std::size_t end){
+    std::string_view segment = str.substr(0, end);
+    for(std::size_t i = delimiters.find(segment, start); i < end; i = delimiters.find(segment, i + 1)){
+      if(!on_match(i))
+        return(false);
+    }
+    return(true);
+  }));
+}
+
+#endif
@@ -1,25 +1,28 @@
 #include <Rcpp.h>
 #include "string_operations.h"
 #include "check_syntax.h"
+#include "diagnostics.h"
 
-std::vector<str_rhs_elem> split_eqation_rhs(std::string rhs){
+std::pmr::vector<str_rhs_elem> split_eqation_rhs(std::string_view rhs,
+                                                 std::pmr::memory_resource* mr){
 
-  std::vector<str_rhs_elem> str_elems;
+  std::pmr::vector<str_rhs_elem> str_elems(mr);
 
   // split at +. This separates different rhs elements
-  std::vector<std::string> rhs_split = split_string_all(rhs, '+');
+  std::pmr::vector<std::string_view> rhs_split = split_string_all(rhs, '+', mr);
+  str_elems.reserve(rhs_split.size());
 
   // split right hand side further at the modifier
-  for(std::string rhs_split_elem: rhs_split){
+  for(std::string_view rhs_split_elem: rhs_split){
     str_rhs_elem current_elem;
 
     // check for modifier (*)
-    std::vector<std::string> split_modifiers = split_string_all(rhs_split_elem, '*');
+    std::pmr::vector<std::string_view> split_modifiers = split_string_all(rhs_split_elem, '*', mr);
 
     if(split_modifiers.size() > 2){
 
-      Rcpp::stop("The following element seems to have more than two modifiers: " +
-        rhs_split_elem);
+      parse_stop("The following element seems to have more than two modifiers: " +
+        std::string(rhs_split_elem));
 
     }else if(split_modifiers.size() == 2){
 
@@ -30,11 +33,11 @@ std::vector<str_rhs_elem> split_eqation_rhs(std::string rhs){
 
     }else if(split_modifiers.size() == 1){
 
-      current_elem.modifier = "";
+      current_elem.modifier = std::string_view();
       current_elem.rhs      = split_modifiers.at(0);
 
     }else{
-      Rcpp::stop("Could not parse the following element: " + rhs_split_elem);
+      parse_stop("Could not parse the following element: " + std::string(rhs_split_elem));
     }
 
     str_elems.push_back(current_elem);
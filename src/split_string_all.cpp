@@ -1,5 +1,7 @@
 #include <Rcpp.h>
 #include "string_operations.h"
+#include "diagnostics.h"
+#include "scan.h"
 
 //' split_string_all
 //'
@@ -10,46 +12,37 @@
 //' @keywords internal
 // [[Rcpp::export]]
 std::vector<std::string> split_string_all(const std::string& str, const char at){
+  std::pmr::vector<std::string_view> splitted_str = split_string_all(std::string_view(str),
+                                                                     at,
+                                                                     std::pmr::get_default_resource());
+  return(std::vector<std::string>(splitted_str.begin(), splitted_str.end()));
+}
+
+std::pmr::vector<std::string_view> split_string_all(std::string_view str,
+                                                    const char at,
+                                                    std::pmr::memory_resource* mr){
   // adapted from Vincenzo Pii at https://stackoverflow.com/questions/14265581/parse-split-a-string-in-c-using-string-delimiter-standard-c
 
-  std::string base_string = str;
-  std::vector<std::string> splitted_str;
-  int n_curly_open = 0; // indicates if the user specified a block of code
-  // that should not be changed
-
-  std::string current_element = "";
-
-  for(char c: str){
-    // check for curly braces:
-    switch(c){
-    case '{':
-      n_curly_open++;
-      break;
-    case '}':
-      n_curly_open--;
-      if(n_curly_open < 0){
-        Rcpp::stop("Error parsing the syntax: Found a closing curly brace } without an opening curly brance {. The last line was "  +
-          str);
-      }
-      break;
-    }
-
-    if((n_curly_open != 0) | (c == '}')){
-      current_element += c;
-      continue;
-    }
-
-    if(c == at){
-      // split string
-      splitted_str.push_back(current_element);
-      current_element = "";
-    }else{
-      current_element += c;
-    }
-  }
-
-  if(current_element.length() != 0)
-    splitted_str.push_back(current_element);
+  // the elements are contiguous parts of str; we only store where they start
+  // and end instead of copying them character by character.
+  std::pmr::vector<std::string_view> splitted_str(mr);
+
+  // delimiters within curly braces are a block of code that should not be changed
+  std::size_t element_start = 0;
+  auto split_at = [&](std::size_t position){
+    splitted_str.push_back(str.substr(element_start, position - element_start));
+    element_start = position + 1;
+    return(true);
+  };
+
+  std::size_t unmatched = for_each_top_level(str, byte_set(std::string_view(&at, 1)), split_at);
+
+  if(unmatched != std::string_view::npos)
+    parse_stop("Error parsing the syntax: Found a closing curly brace } without an opening curly brance {. The last line was "  +
+      std::string(str));
+
+  if(element_start < str.size())
+    splitted_str.push_back(str.substr(element_start));
 
   return(splitted_str);
 }
@@ -1,28 +1,37 @@
 #ifndef STR_OPERATIONS_H
 #define STR_OPERATIONS_H
 #include <Rcpp.h>
+#include <memory_resource>
+#include <string_view>
 
+// the elements returned by the splitting functions are views into the string
+// that was split and must not outlive it.
 struct equation_elements{
-  std::string lhs{""};
-  std::string separator{""};
-  std::string rhs{""};
+  std::string_view lhs{};
+  std::string_view separator{};
+  std::string_view rhs{};
 };
 
 struct str_rhs_elem{
-  std::string rhs = "";
-  std::string modifier = "";
+  std::string_view rhs{};
+  std::string_view modifier{};
 };
 
-std::vector<str_rhs_elem> split_eqation_rhs(std::string rhs);
+std::pmr::vector<str_rhs_elem> split_eqation_rhs(std::string_view rhs,
+                                                 std::pmr::memory_resource* mr);
 
-equation_elements split_string_once(const std::string& str, const std::string& at);
+equation_elements split_string_once(std::string_view str, std::string_view at);
 
 std::vector<std::string> split_string_all(const std::string& str, const char at);
 
-void check_lhs(const std::string& lhs, const std::string not_allowed = "!+*=~:");
+std::pmr::vector<std::string_view> split_string_all(std::string_view str,
+                                                    const char at,
+                                                    std::pmr::memory_resource* mr);
 
-bool char_in_string(const char c, const std::string& str);
+void check_lhs(std::string_view lhs, std::string_view not_allowed = "!+*=~:");
 
-bool is_number(const std::string& str);
+bool char_in_string(const char c, std::string_view str);
+
+bool is_number(std::string_view str);
 
 #endif